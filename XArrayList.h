@@ -56,6 +56,11 @@ public:
         this->deleteUserData = deleteUserData;
     }
 
+    /* reserve(int capacity): make the array large enough for "capacity" items,
+     *      so that the next (capacity - size()) calls of add do not reallocate
+     */
+    void reserve(int capacity);
+
     Iterator begin()
     {
         return Iterator(this, 0);
@@ -233,18 +238,11 @@ template <class T>
 XArrayList<T>::XArrayList(const XArrayList<T> &list)
 {
     // TODO
-    if (deleteUserData != 0) {
-        deleteUserData(this);
-    }
-    delete[] data;
-    capacity = list.capacity;
-    count = list.count;
-    data = new T[capacity];
-    setDeleteUserDataPtr(list.deleteUserData);
-    itemEqual = list.itemEqual;
-    for (int i = 0; i < count; i++) {
-        data[i] = list.data[i];
-    }
+    deleteUserData = 0; // nothing to release yet: members are not initialized
+    data = nullptr;
+    count = 0;
+    capacity = 0;
+    copyFrom(list);
 }
 
 template <class T>
@@ -282,16 +280,11 @@ void XArrayList<T>::add(int index, T e)
         ensureCapacity(count);
     }
     catch (...) { return; }
-    T temp = data[index], temp2 = data[index + 1];
+    for (int i = count; i > index; i--) {
+        data[i] = data[i - 1];
+    }
     data[index] = e;
     count++;
-    for (int i = index + 1; i < count; i++) {
-        data[index] = temp;
-        temp = temp2;
-        if (index != count - 1) {
-            temp2 = data[index + 1];
-        }
-    }
 }
 
 template <class T>
@@ -303,7 +296,7 @@ T XArrayList<T>::removeAt(int index)
     }
     T result = data[index];
     for (int i = index; i < count - 1; i++) {
-        data[index] = data[index + 1];
+        data[i] = data[i + 1];
     }
     count--;
     return result;
@@ -419,6 +412,21 @@ string XArrayList<T>::toString(string (*item2str)(T &))
     return "[" + result.substr(2) + "]";
 }
 
+template <class T>
+void XArrayList<T>::reserve(int capacity)
+{
+    if (capacity <= this->capacity) {
+        return;
+    }
+    T* temp = new T[capacity];
+    for (int i = 0; i < count; i++) {
+        temp[i] = data[i];
+    }
+    delete[] data;
+    data = temp;
+    this->capacity = capacity;
+}
+
 //////////////////////////////////////////////////////////////////////
 //////////////////////// (private) METHOD DEFNITION //////////////////
 //////////////////////////////////////////////////////////////////////
@@ -450,14 +458,10 @@ void XArrayList<T>::ensureCapacity(int index)
         throw out_of_range("Index is out of range!");
     }
     try {
-        if (index == capacity) {
-            capacity++;
-            T* temp = new T[capacity];
-            for (int i = 0; i < capacity; i++) {
-                temp[i] = data[i];
-            }
-            delete[] data;
-            data = temp;
+        if (index >= capacity) {
+            // grow geometrically so that n calls of add(e) cost O(n) copies in total
+            int newCapacity = capacity + capacity / 2 + 1;
+            reserve(newCapacity > index ? newCapacity : index + 1);
         }
     }
     catch (std::bad_alloc&) {
@@ -16,6 +16,7 @@
 #include <iostream>
 #include <iomanip>
 #include "XArrayList.h"
+#include "XIndexedList.h"
 #include "util/Point.h"
 using namespace std;
 
@@ -83,5 +84,22 @@ void xlistDemo4(){
     delete p2;
 }
 
+void xlistDemo5(){
+    //points closer than EPSILON are equal: the hashed lookup finds them as the linear one does
+    XIndexedList<Point*> list1(&XArrayList<Point*>::free, &Point::pointEQ, &Point::pointHash);
+    XArrayList<Point*> list2(0, &Point::pointEQ);
+    Point* items[] = { new Point(0.01f, 23.1f), new Point(24.6f, 0.0f), new Point(-0.05f, 0.1f, 0.125f) };
+    for(int idx=0; idx < 3; idx++){
+        list1.add(items[idx]);
+        list2.add(items[idx]);
+    }
+    Point* keys[] = { new Point(0.01f + 5E-9f, 23.1f), new Point(24.6f, -3E-9f), new Point(-0.05f, 0.1f, 0.125f - 7E-9f) };
+    for(int idx=0; idx < 3; idx++){
+        cout << *keys[idx] << "=> indexOf (hashed): " << list1.indexOf(keys[idx])
+                    << ", indexOf (linear): " << list2.indexOf(keys[idx]) << endl;
+        delete keys[idx];
+    }
+}
+
 #endif /* XARRAYLISTDEMO_H */
 
@@ -0,0 +1,559 @@
+/*
+ * File:   XHashMap.h
+ */
+
+#ifndef XHASHMAP_H
+#define XHASHMAP_H
+#include "XArrayList.h"
+#include "util/Hash.h"
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+using namespace std;
+
+/* XHashMap<K, V>:
+ *  + hash map with open addressing and Robin Hood probing:
+ *      each slot keeps the distance from its home slot (probe length);
+ *      an inserted entry takes the slot of a "richer" entry (shorter probe length)
+ *      and that entry goes on probing => probe lengths stay short and uniform
+ *  + lookup stops as soon as the probe length of a slot is shorter than the current one
+ *  + remove shifts the following entries backward (no tombstone)
+ *  + the table grows (x2) when size > capacity * maxLoadFactor
+ *  + keyEqual given (e.g., compare the content of pointers) => keyHash must be given too
+ *  >> throw an exception (std::invalid_argument) if keyHash is missing (see: checkHash in util/Hash.h)
+ */
+template <class K, class V>
+class XHashMap
+{
+public:
+    class Entry;    // forward declaration
+    class Iterator; // forward declaration
+
+protected:
+    Entry *table;                                // slots of the table
+    int *probe;                                  // probe[i]: 0 if slot i is empty, else distance from home slot + 1
+    size_t *hashes;                              // cached hash of the key in each slot
+    int capacity;                                // number of slots, always a power of 2
+    int count;                                   // number of entries stored in the table
+    float maxLoadFactor;                         // grow when count > capacity * maxLoadFactor
+    bool (*keyEqual)(K &lhs, K &rhs);            // function pointer: test if two keys are equal or not
+    size_t (*keyHash)(K &);                      // function pointer: compute hash of a key
+    void (*deleteKeys)(XHashMap<K, V> *);        // function pointer: be called to remove keys (if they are pointer type)
+    void (*deleteValues)(XHashMap<K, V> *);      // function pointer: be called to remove values (if they are pointer type)
+
+public:
+    XHashMap(
+        void (*deleteKeys)(XHashMap<K, V> *) = 0,
+        void (*deleteValues)(XHashMap<K, V> *) = 0,
+        bool (*keyEqual)(K &, K &) = 0,
+        size_t (*keyHash)(K &) = 0,
+        int capacity = 10,
+        float maxLoadFactor = 0.75f);
+    XHashMap(const XHashMap<K, V> &map);
+    XHashMap<K, V> &operator=(const XHashMap<K, V> &map);
+    ~XHashMap();
+
+    /* put(K key, V value): insert (key, value); if key exists, replace its value
+     * return:
+     *  >> the old value if key exists; otherwise, value
+     */
+    V put(K key, V value);
+
+    /* get(K key): return a reference to the value of key
+     *  >> throw an exception (std::out_of_range) if key is not found
+     */
+    V &get(K key);
+
+    /* remove(K key, void (*deleteKeyInMap)(K)=0): remove the entry of key
+     *   >> deleteKeyInMap: a function pointer (maybe NULL, default),
+     *          that will be called to delete the key stored in the map
+     * return:
+     *  >> the value of key
+     *  >> throw an exception (std::out_of_range) if key is not found
+     */
+    V remove(K key, void (*deleteKeyInMap)(K) = 0);
+
+    bool containsKey(K key);
+    bool containsValue(V value, bool (*valueEqual)(V &, V &) = 0);
+    bool empty();
+    int size();
+    void clear();
+
+    /* reserve(int n): allocate enough slots for n entries (w.r.t. maxLoadFactor)
+     *      so that n calls of put do not rehash
+     */
+    void reserve(int n);
+    void setMaxLoadFactor(float maxLoadFactor);
+    float loadFactor() { return capacity == 0 ? 0.0f : (float)count / capacity; }
+
+    XArrayList<K> keys();
+    XArrayList<V> values();
+
+    string toString(string (*key2str)(K &) = 0, string (*value2str)(V &) = 0);
+    void println(string (*key2str)(K &) = 0, string (*value2str)(V &) = 0)
+    {
+        cout << toString(key2str, value2str) << endl;
+    }
+    void setDeleteKeysPtr(void (*deleteKeys)(XHashMap<K, V> *) = 0)
+    {
+        this->deleteKeys = deleteKeys;
+    }
+    void setDeleteValuesPtr(void (*deleteValues)(XHashMap<K, V> *) = 0)
+    {
+        this->deleteValues = deleteValues;
+    }
+
+    Iterator begin()
+    {
+        return Iterator(this, 0);
+    }
+    Iterator end()
+    {
+        return Iterator(this, capacity);
+    }
+
+    /** freeKey, freeValue:
+     * if K (or V) is pointer type:
+     *     pass THE address of freeKey (or freeValue) to XHashMap<K, V>'s constructor
+     * Example:
+     *  XHashMap<Point*, int> map(&XHashMap<Point*, int>::freeKey, 0, &Point::pointEQ, &Point::pointHash);
+     */
+    static void freeKey(XHashMap<K, V> *map)
+    {
+        for (typename XHashMap<K, V>::Iterator it = map->begin(); it != map->end(); it++)
+            delete (*it).key;
+    }
+    static void freeValue(XHashMap<K, V> *map)
+    {
+        for (typename XHashMap<K, V>::Iterator it = map->begin(); it != map->end(); it++)
+            delete (*it).value;
+    }
+
+protected:
+    static bool equals(K &lhs, K &rhs, bool (*keyEqual)(K &, K &))
+    {
+        if (keyEqual == 0)
+            return lhs == rhs;
+        else
+            return keyEqual(lhs, rhs);
+    }
+    int find(K &key, size_t h);
+    void insert(K key, V value, size_t h);
+    void rehash(int newCapacity);
+    void allocate(int capacity);
+    void copyFrom(const XHashMap<K, V> &map);
+    void removeInternalData();
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    class Entry
+    {
+    public:
+        K key;
+        V value;
+        Entry() : key(), value() {}
+        Entry(K key, V value) : key(key), value(value) {}
+    };
+
+    // Iterator: BEGIN
+    class Iterator
+    {
+    private:
+        int cursor;
+        XHashMap<K, V> *pMap;
+
+        void skipEmpty()
+        {
+            while (cursor < pMap->capacity && pMap->probe[cursor] == 0)
+                cursor++;
+        }
+
+    public:
+        Iterator(XHashMap<K, V> *pMap = 0, int index = 0)
+        {
+            this->pMap = pMap;
+            this->cursor = index;
+            if (pMap != 0)
+                skipEmpty();
+        }
+        Iterator &operator=(const Iterator &iterator)
+        {
+            cursor = iterator.cursor;
+            pMap = iterator.pMap;
+            return *this;
+        }
+        Entry &operator*()
+        {
+            return pMap->table[cursor];
+        }
+        bool operator!=(const Iterator &iterator)
+        {
+            return cursor != iterator.cursor;
+        }
+        // Prefix ++ overload
+        Iterator &operator++()
+        {
+            this->cursor++;
+            skipEmpty();
+            return *this;
+        }
+        // Postfix ++ overload
+        Iterator operator++(int)
+        {
+            Iterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+    };
+    // Iterator: END
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class K, class V>
+XHashMap<K, V>::XHashMap(
+    void (*deleteKeys)(XHashMap<K, V> *),
+    void (*deleteValues)(XHashMap<K, V> *),
+    bool (*keyEqual)(K &, K &),
+    size_t (*keyHash)(K &),
+    int capacity,
+    float maxLoadFactor)
+{
+    checkHash(keyEqual, keyHash);
+    this->deleteKeys = deleteKeys;
+    this->deleteValues = deleteValues;
+    this->keyEqual = keyEqual;
+    this->keyHash = keyHash;
+    this->maxLoadFactor = (maxLoadFactor > 0.0f && maxLoadFactor < 1.0f) ? maxLoadFactor : 0.75f;
+    table = 0;
+    probe = 0;
+    hashes = 0;
+    count = 0;
+    this->capacity = 0;
+    reserve(capacity);
+}
+
+template <class K, class V>
+XHashMap<K, V>::XHashMap(const XHashMap<K, V> &map)
+{
+    table = 0;
+    probe = 0;
+    hashes = 0;
+    count = 0;
+    capacity = 0;
+    deleteKeys = 0;
+    deleteValues = 0;
+    copyFrom(map);
+}
+
+template <class K, class V>
+XHashMap<K, V> &XHashMap<K, V>::operator=(const XHashMap<K, V> &map)
+{
+    if (this != &map)
+    {
+        removeInternalData();
+        copyFrom(map);
+    }
+    return *this;
+}
+
+template <class K, class V>
+XHashMap<K, V>::~XHashMap()
+{
+    removeInternalData();
+}
+
+template <class K, class V>
+V XHashMap<K, V>::put(K key, V value)
+{
+    size_t h = hashItem(key, keyHash);
+    int index = find(key, h);
+    if (index != -1)
+    {
+        V old = table[index].value;
+        table[index].value = value;
+        return old;
+    }
+    if (count + 1 > capacity * maxLoadFactor)
+        rehash(capacity == 0 ? 16 : capacity * 2);
+    insert(key, value, h);
+    count++;
+    return value;
+}
+
+template <class K, class V>
+V &XHashMap<K, V>::get(K key)
+{
+    int index = find(key, hashItem(key, keyHash));
+    if (index == -1)
+        throw out_of_range("Key is not found!");
+    return table[index].value;
+}
+
+template <class K, class V>
+V XHashMap<K, V>::remove(K key, void (*deleteKeyInMap)(K))
+{
+    int index = find(key, hashItem(key, keyHash));
+    if (index == -1)
+        throw out_of_range("Key is not found!");
+    V value = table[index].value;
+    if (deleteKeyInMap != 0)
+        deleteKeyInMap(table[index].key);
+    // backward shift: pull the following entries of the cluster one slot closer to their home
+    int mask = capacity - 1;
+    int next = (index + 1) & mask;
+    while (probe[next] > 1)
+    {
+        table[index] = std::move(table[next]);
+        hashes[index] = hashes[next];
+        probe[index] = probe[next] - 1;
+        index = next;
+        next = (next + 1) & mask;
+    }
+    table[index] = Entry();
+    probe[index] = 0;
+    count--;
+    return value;
+}
+
+template <class K, class V>
+bool XHashMap<K, V>::containsKey(K key)
+{
+    return find(key, hashItem(key, keyHash)) != -1;
+}
+
+template <class K, class V>
+bool XHashMap<K, V>::containsValue(V value, bool (*valueEqual)(V &, V &))
+{
+    for (int i = 0; i < capacity; i++)
+    {
+        if (probe[i] == 0)
+            continue;
+        if (valueEqual == 0 ? table[i].value == value : valueEqual(table[i].value, value))
+            return true;
+    }
+    return false;
+}
+
+template <class K, class V>
+bool XHashMap<K, V>::empty()
+{
+    return count == 0;
+}
+
+template <class K, class V>
+int XHashMap<K, V>::size()
+{
+    return count;
+}
+
+template <class K, class V>
+void XHashMap<K, V>::clear()
+{
+    if (deleteKeys != 0)
+        deleteKeys(this);
+    if (deleteValues != 0)
+        deleteValues(this);
+    for (int i = 0; i < capacity; i++)
+    {
+        if (probe[i] != 0)
+            table[i] = Entry();
+        probe[i] = 0;
+    }
+    count = 0;
+}
+
+template <class K, class V>
+void XHashMap<K, V>::reserve(int n)
+{
+    int newCapacity = capacity == 0 ? 16 : capacity;
+    while (n > newCapacity * maxLoadFactor)
+        newCapacity *= 2;
+    if (newCapacity != capacity)
+        rehash(newCapacity);
+}
+
+template <class K, class V>
+void XHashMap<K, V>::setMaxLoadFactor(float maxLoadFactor)
+{
+    if (maxLoadFactor <= 0.0f || maxLoadFactor >= 1.0f)
+        throw out_of_range("Load factor must be in (0, 1)!");
+    this->maxLoadFactor = maxLoadFactor;
+    reserve(count);
+}
+
+template <class K, class V>
+XArrayList<K> XHashMap<K, V>::keys()
+{
+    XArrayList<K> result(0, keyEqual, count + 1);
+    for (int i = 0; i < capacity; i++)
+        if (probe[i] != 0)
+            result.add(table[i].key);
+    return result;
+}
+
+template <class K, class V>
+XArrayList<V> XHashMap<K, V>::values()
+{
+    XArrayList<V> result(0, 0, count + 1);
+    for (int i = 0; i < capacity; i++)
+        if (probe[i] != 0)
+            result.add(table[i].value);
+    return result;
+}
+
+template <class K, class V>
+string XHashMap<K, V>::toString(string (*key2str)(K &), string (*value2str)(V &))
+{
+    /**
+     * Converts the map into a string: {key1: value1, key2: value2, ...}
+     * Entries are listed in the order of slots, not in the order of insertion.
+     */
+    stringstream ss;
+    ss << "{";
+    bool first = true;
+    for (int i = 0; i < capacity; i++)
+    {
+        if (probe[i] == 0)
+            continue;
+        if (!first)
+            ss << ", ";
+        first = false;
+        if (key2str != 0)
+            ss << key2str(table[i].key);
+        else
+            ss << table[i].key;
+        ss << ": ";
+        if (value2str != 0)
+            ss << value2str(table[i].value);
+        else
+            ss << table[i].value;
+    }
+    ss << "}";
+    return ss.str();
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+template <class K, class V>
+int XHashMap<K, V>::find(K &key, size_t h)
+{
+    /**
+     * Returns the slot of key, or -1.
+     * Robin Hood invariant: if the probe length of slot i is shorter than ours,
+     *      key would have been stored there => key is not in the table.
+     */
+    if (capacity == 0)
+        return -1;
+    int mask = capacity - 1;
+    int i = (int)(h & mask);
+    for (int dist = 1; probe[i] >= dist; dist++)
+    {
+        if (hashes[i] == h && equals(table[i].key, key, keyEqual))
+            return i;
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+template <class K, class V>
+void XHashMap<K, V>::insert(K key, V value, size_t h)
+{
+    /**
+     * Places (key, value) with Robin Hood probing; key must not be in the table
+     * and there must be a free slot.
+     */
+    Entry entry(key, value);
+    int mask = capacity - 1;
+    int i = (int)(h & mask);
+    int dist = 1;
+    while (probe[i] != 0)
+    {
+        if (probe[i] < dist)
+        {
+            // the resident is closer to its home: take its slot, carry it forward
+            std::swap(table[i], entry);
+            std::swap(hashes[i], h);
+            std::swap(probe[i], dist);
+        }
+        i = (i + 1) & mask;
+        dist++;
+    }
+    table[i] = std::move(entry);
+    hashes[i] = h;
+    probe[i] = dist;
+}
+
+template <class K, class V>
+void XHashMap<K, V>::rehash(int newCapacity)
+{
+    Entry *oldTable = table;
+    int *oldProbe = probe;
+    size_t *oldHashes = hashes;
+    int oldCapacity = capacity;
+    allocate(newCapacity);
+    for (int i = 0; i < oldCapacity; i++)
+        if (oldProbe[i] != 0)
+            insert(oldTable[i].key, oldTable[i].value, oldHashes[i]);
+    delete[] oldTable;
+    delete[] oldProbe;
+    delete[] oldHashes;
+}
+
+template <class K, class V>
+void XHashMap<K, V>::allocate(int capacity)
+{
+    this->capacity = capacity;
+    table = new Entry[capacity];
+    probe = new int[capacity];
+    hashes = new size_t[capacity];
+    for (int i = 0; i < capacity; i++)
+        probe[i] = 0;
+}
+
+template <class K, class V>
+void XHashMap<K, V>::copyFrom(const XHashMap<K, V> &map)
+{
+    /*
+     * Copies the table of another map: same capacity, same slots (no rehash).
+     * The delete hooks are copied as well, as in XArrayList.
+     */
+    deleteKeys = map.deleteKeys;
+    deleteValues = map.deleteValues;
+    keyEqual = map.keyEqual;
+    keyHash = map.keyHash;
+    maxLoadFactor = map.maxLoadFactor;
+    count = map.count;
+    allocate(map.capacity);
+    for (int i = 0; i < capacity; i++)
+    {
+        probe[i] = map.probe[i];
+        if (probe[i] != 0)
+        {
+            table[i] = map.table[i];
+            hashes[i] = map.hashes[i];
+        }
+    }
+}
+
+template <class K, class V>
+void XHashMap<K, V>::removeInternalData()
+{
+    if (capacity != 0)
+        clear();
+    delete[] table;
+    delete[] probe;
+    delete[] hashes;
+    table = 0;
+    probe = 0;
+    hashes = 0;
+    capacity = 0;
+}
+
+#endif /* XHASHMAP_H */
@@ -0,0 +1,182 @@
+/*
+ * File:   XHashSet.h
+ */
+
+#ifndef XHASHSET_H
+#define XHASHSET_H
+#include "XHashMap.h"
+using namespace std;
+
+/* XHashSet<T>:
+ *  + a set of items stored as the keys of an XHashMap<T, char>
+ *      (open addressing, Robin Hood probing; see XHashMap.h)
+ *  + add, remove, contains: O(1) expected
+ *  + itemEqual given => itemHash must be given too (see: XHashMap)
+ */
+template <class T>
+class XHashSet
+{
+public:
+    class Iterator; // forward declaration
+
+protected:
+    XHashMap<T, char> map;
+    void (*deleteUserData)(XHashSet<T> *); // function pointer: be called to remove items (if they are pointer type)
+
+public:
+    XHashSet(
+        void (*deleteUserData)(XHashSet<T> *) = 0,
+        bool (*itemEqual)(T &, T &) = 0,
+        size_t (*itemHash)(T &) = 0,
+        int capacity = 10,
+        float maxLoadFactor = 0.75f) : map(0, 0, itemEqual, itemHash, capacity, maxLoadFactor)
+    {
+        this->deleteUserData = deleteUserData;
+    }
+    XHashSet(const XHashSet<T> &set) : map(set.map)
+    {
+        this->deleteUserData = set.deleteUserData;
+    }
+    XHashSet<T> &operator=(const XHashSet<T> &set)
+    {
+        if (this != &set)
+        {
+            clear();
+            map = set.map;
+            deleteUserData = set.deleteUserData;
+        }
+        return *this;
+    }
+    ~XHashSet()
+    {
+        if (deleteUserData != 0)
+            deleteUserData(this);
+    }
+
+    /* add(T item): return true if item is added; false if it is already in the set
+     */
+    bool add(T item)
+    {
+        int oldCount = map.size();
+        map.put(item, 0);
+        return map.size() != oldCount;
+    }
+    /* remove(T item, void (*removeItemData)(T)=0): return true if item was in the set
+     *   >> removeItemData: called on the item stored in the set (maybe NULL, default)
+     */
+    bool remove(T item, void (*removeItemData)(T) = 0)
+    {
+        if (!map.containsKey(item))
+            return false;
+        map.remove(item, removeItemData);
+        return true;
+    }
+    bool contains(T item) { return map.containsKey(item); }
+    bool empty() { return map.empty(); }
+    int size() { return map.size(); }
+    void clear()
+    {
+        if (deleteUserData != 0)
+            deleteUserData(this);
+        map.clear();
+    }
+    void reserve(int n) { map.reserve(n); }
+    void setMaxLoadFactor(float maxLoadFactor) { map.setMaxLoadFactor(maxLoadFactor); }
+    float loadFactor() { return map.loadFactor(); }
+    XArrayList<T> toList() { return map.keys(); }
+
+    string toString(string (*item2str)(T &) = 0)
+    {
+        stringstream ss;
+        ss << "{";
+        bool first = true;
+        for (Iterator it = begin(); it != end(); it++)
+        {
+            if (!first)
+                ss << ", ";
+            first = false;
+            if (item2str != 0)
+                ss << item2str(*it);
+            else
+                ss << *it;
+        }
+        ss << "}";
+        return ss.str();
+    }
+    void println(string (*item2str)(T &) = 0)
+    {
+        cout << toString(item2str) << endl;
+    }
+    void setDeleteUserDataPtr(void (*deleteUserData)(XHashSet<T> *) = 0)
+    {
+        this->deleteUserData = deleteUserData;
+    }
+
+    Iterator begin()
+    {
+        return Iterator(map.begin());
+    }
+    Iterator end()
+    {
+        return Iterator(map.end());
+    }
+
+    /** free:
+     * if T is pointer type:
+     *     pass THE address of method "free" to XHashSet<T>'s constructor
+     * Example:
+     *  XHashSet<Point*> set(&XHashSet<Point*>::free, &Point::pointEQ, &Point::pointHash);
+     */
+    static void free(XHashSet<T> *set)
+    {
+        for (typename XHashSet<T>::Iterator it = set->begin(); it != set->end(); it++)
+            delete *it;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    // Iterator: BEGIN
+    class Iterator
+    {
+    private:
+        typename XHashMap<T, char>::Iterator it;
+
+    public:
+        Iterator(typename XHashMap<T, char>::Iterator it = typename XHashMap<T, char>::Iterator())
+        {
+            this->it = it;
+        }
+        Iterator &operator=(const Iterator &iterator)
+        {
+            it = iterator.it;
+            return *this;
+        }
+        // NOTE: do not change the item, its slot depends on its hash
+        T &operator*()
+        {
+            return (*it).key;
+        }
+        bool operator!=(const Iterator &iterator)
+        {
+            return it != iterator.it;
+        }
+        // Prefix ++ overload
+        Iterator &operator++()
+        {
+            ++it;
+            return *this;
+        }
+        // Postfix ++ overload
+        Iterator operator++(int)
+        {
+            Iterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+    };
+    // Iterator: END
+};
+
+#endif /* XHASHSET_H */
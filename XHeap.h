@@ -0,0 +1,413 @@
+/*
+ * File:   XHeap.h
+ */
+
+#ifndef XHEAP_H
+#define XHEAP_H
+#include "XArrayList.h"
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+using namespace std;
+
+/* XHeap<T, D>:
+ *  + a D-ary heap (D = 2: binary heap) stored in an XArrayList
+ *  + the item at the top is the one with the smallest "compare" (see: compare)
+ *      => min-heap by default; pass a comparator to change the order (e.g., max-heap)
+ *  + push, pop: O(log_D(n)); top: O(1); heapify: O(n)
+ *  + push returns a handle: use it to reach the item later (get, decreaseKey)
+ *      a handle is valid until its item leaves the heap (pop, clear)
+ *
+ * D = 4 (XHeap4): the D children of a node are adjacent in memory
+ *      and the tree is half as deep => fewer cache misses on large heaps
+ */
+template <class T, int D = 2>
+class XHeap
+{
+public:
+    class Iterator; // forward declaration
+
+protected:
+    XArrayList<T> items;                     // the heap, in array order
+    XArrayList<int> handleAt;                // handleAt[pos]: handle of the item at position pos
+    XArrayList<int> posOf;                   // posOf[handle]: position of the item, -1 if not in heap
+    XArrayList<int> freeHandles;             // handles that can be given again
+    int (*comparator)(T &lhs, T &rhs);       // function pointer: compare two items (see: compare)
+    void (*deleteUserData)(XHeap<T, D> *);   // function pointer: be called to remove items (if they are pointer type)
+
+public:
+    XHeap(
+        int (*comparator)(T &, T &) = 0,
+        void (*deleteUserData)(XHeap<T, D> *) = 0,
+        int capacity = 10);
+    XHeap(XArrayList<T> &list,
+          int (*comparator)(T &, T &) = 0,
+          void (*deleteUserData)(XHeap<T, D> *) = 0);
+    ~XHeap();
+
+    /* push(T item): insert item into the heap
+     * return:
+     *  >> the handle of item
+     */
+    int push(T item);
+
+    /* pop(): remove the item at the top
+     * return:
+     *  >> the removed item
+     *  >> throw an exception (std::underflow_error) if the heap is empty
+     */
+    T pop();
+
+    /* top(): return a reference to the item at the top
+     *  >> throw an exception (std::underflow_error) if the heap is empty
+     * NOTE: do not change the item, use decreaseKey
+     */
+    T &top();
+
+    /* heapify(XArrayList<T>& list): replace the content of the heap by the items of list
+     *      in O(n) (bottom-up, Floyd's method); handle of list.get(i) is i
+     */
+    void heapify(XArrayList<T> &list);
+
+    /* decreaseKey(int handle, T item): replace the item of handle by "item"
+     *      which must come before the old one (compare(item, old) <= 0), then move it up
+     *  >> throw an exception (std::out_of_range) if handle is not in the heap
+     *  >> throw an exception (std::invalid_argument) if item comes after the old one
+     */
+    void decreaseKey(int handle, T item);
+
+    /* get(int handle): return a reference to the item of handle
+     *  >> throw an exception (std::out_of_range) if handle is not in the heap
+     */
+    T &get(int handle);
+    bool contains(int handle);
+
+    bool empty();
+    int size();
+    void clear();
+    string toString(string (*item2str)(T &) = 0);
+    void println(string (*item2str)(T &) = 0)
+    {
+        cout << toString(item2str) << endl;
+    }
+    void setDeleteUserDataPtr(void (*deleteUserData)(XHeap<T, D> *) = 0)
+    {
+        this->deleteUserData = deleteUserData;
+    }
+
+    Iterator begin()
+    {
+        return Iterator(this, 0);
+    }
+    Iterator end()
+    {
+        return Iterator(this, items.size());
+    }
+
+    /** free:
+     * if T is pointer type:
+     *     pass THE address of method "free" to XHeap's constructor
+     * Example:
+     *  XHeap<Point*> heap(&comparePoint, &XHeap<Point*>::free);
+     */
+    static void free(XHeap<T, D> *heap)
+    {
+        for (typename XHeap<T, D>::Iterator it = heap->begin(); it != heap->end(); it++)
+            delete *it;
+    }
+
+protected:
+    /** compare:
+     * if comparator == 0: use native operator < (class of type T MUST override operator <)
+     *      return -1 if lhs < rhs, +1 if rhs < lhs, 0 otherwise
+     * else: return comparator(lhs, rhs)
+     * The item with the smallest compare stays at the top.
+     */
+    static int compare(T &lhs, T &rhs, int (*comparator)(T &, T &))
+    {
+        if (comparator == 0)
+        {
+            if (lhs < rhs)
+                return -1;
+            else if (rhs < lhs)
+                return +1;
+            else
+                return 0;
+        }
+        else
+            return comparator(lhs, rhs);
+    }
+    void siftUp(int pos);
+    void siftDown(int pos);
+    void place(int pos, T &item, int handle);
+    int newHandle();
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    // Iterator: BEGIN
+    // traverse the items in array order (NOT in sorted order)
+    class Iterator
+    {
+    private:
+        int cursor;
+        XHeap<T, D> *pHeap;
+
+    public:
+        Iterator(XHeap<T, D> *pHeap = 0, int index = 0)
+        {
+            this->pHeap = pHeap;
+            this->cursor = index;
+        }
+        Iterator &operator=(const Iterator &iterator)
+        {
+            cursor = iterator.cursor;
+            pHeap = iterator.pHeap;
+            return *this;
+        }
+        T &operator*()
+        {
+            return pHeap->items.get(cursor);
+        }
+        bool operator!=(const Iterator &iterator)
+        {
+            return cursor != iterator.cursor;
+        }
+        // Prefix ++ overload
+        Iterator &operator++()
+        {
+            this->cursor++;
+            return *this;
+        }
+        // Postfix ++ overload
+        Iterator operator++(int)
+        {
+            Iterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+    };
+    // Iterator: END
+};
+
+template <class T>
+using XHeap4 = XHeap<T, 4>;
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T, int D>
+XHeap<T, D>::XHeap(
+    int (*comparator)(T &, T &),
+    void (*deleteUserData)(XHeap<T, D> *),
+    int capacity) : items(0, 0, capacity), handleAt(0, 0, capacity), posOf(0, 0, capacity)
+{
+    this->comparator = comparator;
+    this->deleteUserData = deleteUserData;
+}
+
+template <class T, int D>
+XHeap<T, D>::XHeap(
+    XArrayList<T> &list,
+    int (*comparator)(T &, T &),
+    void (*deleteUserData)(XHeap<T, D> *)) : items(0, 0, list.size() + 1),
+                                             handleAt(0, 0, list.size() + 1),
+                                             posOf(0, 0, list.size() + 1)
+{
+    this->comparator = comparator;
+    this->deleteUserData = deleteUserData;
+    heapify(list);
+}
+
+template <class T, int D>
+XHeap<T, D>::~XHeap()
+{
+    if (deleteUserData != 0)
+        deleteUserData(this);
+}
+
+template <class T, int D>
+int XHeap<T, D>::push(T item)
+{
+    int handle = newHandle();
+    items.add(item);
+    handleAt.add(handle);
+    posOf.get(handle) = items.size() - 1;
+    siftUp(items.size() - 1);
+    return handle;
+}
+
+template <class T, int D>
+T XHeap<T, D>::pop()
+{
+    if (items.empty())
+        throw std::underflow_error("Calling to pop with the empty heap.");
+    T result = items.get(0);
+    int last = items.size() - 1;
+    posOf.get(handleAt.get(0)) = -1;
+    freeHandles.add(handleAt.get(0));
+    if (last > 0)
+    {
+        T item = items.get(last);
+        place(0, item, handleAt.get(last));
+    }
+    items.removeAt(last);
+    handleAt.removeAt(last);
+    if (last > 0)
+        siftDown(0);
+    return result;
+}
+
+template <class T, int D>
+T &XHeap<T, D>::top()
+{
+    if (items.empty())
+        throw std::underflow_error("Calling to peek with the empty heap.");
+    return items.get(0);
+}
+
+template <class T, int D>
+void XHeap<T, D>::heapify(XArrayList<T> &list)
+{
+    if (deleteUserData != 0)
+        deleteUserData(this);
+    items = XArrayList<T>(0, 0, list.size() + 1);
+    handleAt = XArrayList<int>(0, 0, list.size() + 1);
+    posOf = XArrayList<int>(0, 0, list.size() + 1);
+    freeHandles = XArrayList<int>();
+    for (int i = 0; i < list.size(); i++)
+    {
+        items.add(list.get(i));
+        handleAt.add(i);
+        posOf.add(i);
+    }
+    // sift down every internal node, from the last one to the root
+    for (int pos = (items.size() - 2) / D; pos >= 0; pos--)
+        siftDown(pos);
+}
+
+template <class T, int D>
+void XHeap<T, D>::decreaseKey(int handle, T item)
+{
+    if (!contains(handle))
+        throw out_of_range("Handle is not in the heap!");
+    int pos = posOf.get(handle);
+    if (compare(item, items.get(pos), comparator) > 0)
+        throw std::invalid_argument("New item comes after the current item!");
+    items.get(pos) = item;
+    siftUp(pos);
+}
+
+template <class T, int D>
+T &XHeap<T, D>::get(int handle)
+{
+    if (!contains(handle))
+        throw out_of_range("Handle is not in the heap!");
+    return items.get(posOf.get(handle));
+}
+
+template <class T, int D>
+bool XHeap<T, D>::contains(int handle)
+{
+    return handle >= 0 && handle < posOf.size() && posOf.get(handle) != -1;
+}
+
+template <class T, int D>
+bool XHeap<T, D>::empty()
+{
+    return items.empty();
+}
+
+template <class T, int D>
+int XHeap<T, D>::size()
+{
+    return items.size();
+}
+
+template <class T, int D>
+void XHeap<T, D>::clear()
+{
+    if (deleteUserData != 0)
+        deleteUserData(this);
+    items = XArrayList<T>();
+    handleAt = XArrayList<int>();
+    posOf = XArrayList<int>();
+    freeHandles = XArrayList<int>();
+}
+
+template <class T, int D>
+string XHeap<T, D>::toString(string (*item2str)(T &))
+{
+    return items.toString(item2str);
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+template <class T, int D>
+void XHeap<T, D>::place(int pos, T &item, int handle)
+{
+    items.get(pos) = item;
+    handleAt.get(pos) = handle;
+    posOf.get(handle) = pos;
+}
+
+template <class T, int D>
+void XHeap<T, D>::siftUp(int pos)
+{
+    /**
+     * Moves the item at pos up while it comes before its parent.
+     * The parents are moved down into the "hole": one write per level instead of a swap.
+     */
+    T item = items.get(pos);
+    int handle = handleAt.get(pos);
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / D;
+        if (compare(item, items.get(parent), comparator) >= 0)
+            break;
+        place(pos, items.get(parent), handleAt.get(parent));
+        pos = parent;
+    }
+    place(pos, item, handle);
+}
+
+template <class T, int D>
+void XHeap<T, D>::siftDown(int pos)
+{
+    /**
+     * Moves the item at pos down while one of its D children comes before it.
+     */
+    int n = items.size();
+    T item = items.get(pos);
+    int handle = handleAt.get(pos);
+    while (true)
+    {
+        int first = D * pos + 1;
+        if (first >= n)
+            break;
+        int last = first + D < n ? first + D : n;
+        int best = first;
+        for (int child = first + 1; child < last; child++)
+            if (compare(items.get(child), items.get(best), comparator) < 0)
+                best = child;
+        if (compare(items.get(best), item, comparator) >= 0)
+            break;
+        place(pos, items.get(best), handleAt.get(best));
+        pos = best;
+    }
+    place(pos, item, handle);
+}
+
+template <class T, int D>
+int XHeap<T, D>::newHandle()
+{
+    if (!freeHandles.empty())
+        return freeHandles.removeAt(freeHandles.size() - 1);
+    posOf.add(-1);
+    return posOf.size() - 1;
+}
+
+#endif /* XHEAP_H */
@@ -0,0 +1,261 @@
+/*
+ * File:   XIndexedList.h
+ */
+
+#ifndef XINDEXEDLIST_H
+#define XINDEXEDLIST_H
+#include "XArrayList.h"
+#include "util/Hash.h"
+using namespace std;
+
+/* XIndexedList<T>:
+ *  + an XArrayList that keeps a hash index (open addressing, linear probing)
+ *      from item to its position in the array
+ *  + contains, indexOf: O(1) expected instead of a linear scan
+ *  + removeItem: O(1) expected to locate the item; the items behind it
+ *      are still shifted (as in XArrayList) to keep the order of the list
+ *  + duplicates are allowed, but all copies of an item share one probe
+ *      sequence: the index is designed for lists with few duplicates (e.g., dedup)
+ *  + itemEqual given => itemHash must be given too
+ *  >> throw an exception (std::invalid_argument) if itemHash is missing (see: checkHash in util/Hash.h)
+ *
+ * NOTE: the index is computed from the content of the items;
+ *      if an item is changed via get(index) or via Iterator,
+ *      call reindex() before the next lookup.
+ */
+template <class T>
+class XIndexedList : public XArrayList<T>
+{
+protected:
+    static const int EMPTY = -1;   // slot never used
+    static const int DELETED = -2; // slot used before (tombstone), probing must go on
+
+    int *slotPos;                  // position of the item in the array, or EMPTY/DELETED
+    size_t *slotHash;              // cached hash of the item, avoid re-hashing when growing
+    int slotCapacity;              // always a power of 2
+    int slotUsed;                  // number of slots != EMPTY (including DELETED)
+    size_t (*itemHash)(T &);       // function pointer: compute hash of an item (type: T&)
+
+public:
+    XIndexedList(
+        void (*deleteUserData)(XArrayList<T> *) = 0,
+        bool (*itemEqual)(T &, T &) = 0,
+        size_t (*itemHash)(T &) = 0,
+        int capacity = 10);
+    XIndexedList(const XIndexedList<T> &list);
+    XIndexedList<T> &operator=(const XIndexedList<T> &list);
+    ~XIndexedList();
+
+    void add(T e);
+    void add(int index, T e);
+    T removeAt(int index);
+    bool removeItem(T item, void (*removeItemData)(T) = 0);
+    void clear();
+    int indexOf(T item);
+    bool contains(T item);
+
+    /* reindex(): rebuild the hash index from the items stored in the array
+     */
+    void reindex();
+
+protected:
+    int findSlot(int pos);
+    void linkSlot(int pos);
+    void allocateSlots(int minItems);
+    void removeIndexData();
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+XIndexedList<T>::XIndexedList(
+    void (*deleteUserData)(XArrayList<T> *),
+    bool (*itemEqual)(T &, T &),
+    size_t (*itemHash)(T &),
+    int capacity) : XArrayList<T>(deleteUserData, itemEqual, capacity)
+{
+    checkHash(itemEqual, itemHash);
+    this->itemHash = itemHash;
+    slotPos = 0;
+    slotHash = 0;
+    allocateSlots(capacity);
+}
+
+template <class T>
+XIndexedList<T>::XIndexedList(const XIndexedList<T> &list) : XArrayList<T>()
+{
+    this->copyFrom(list);
+    itemHash = list.itemHash;
+    slotPos = 0;
+    slotHash = 0;
+    reindex();
+}
+
+template <class T>
+XIndexedList<T> &XIndexedList<T>::operator=(const XIndexedList<T> &list)
+{
+    this->copyFrom(list);
+    itemHash = list.itemHash;
+    reindex();
+    return *this;
+}
+
+template <class T>
+XIndexedList<T>::~XIndexedList()
+{
+    removeIndexData();
+}
+
+template <class T>
+void XIndexedList<T>::add(T e)
+{
+    int oldCount = this->count;
+    XArrayList<T>::add(e);
+    if (this->count != oldCount)
+        linkSlot(this->count - 1);
+}
+
+template <class T>
+void XIndexedList<T>::add(int index, T e)
+{
+    if ((index < 0) || (index > this->count))
+        return; // same as XArrayList: invalid index is ignored
+    // move the positions behind "index" one step to the right (from the back, keep them unique)
+    for (int pos = this->count - 1; pos >= index; pos--)
+        slotPos[findSlot(pos)] = pos + 1;
+    XArrayList<T>::add(index, e);
+    linkSlot(index);
+}
+
+template <class T>
+T XIndexedList<T>::removeAt(int index)
+{
+    if ((index < 0) || (index > this->count - 1)) {
+        throw out_of_range("Index is out of range!");
+    }
+    slotPos[findSlot(index)] = DELETED;
+    // move the positions behind "index" one step to the left (from the front, keep them unique)
+    for (int pos = index + 1; pos < this->count; pos++)
+        slotPos[findSlot(pos)] = pos - 1;
+    return XArrayList<T>::removeAt(index);
+}
+
+template <class T>
+bool XIndexedList<T>::removeItem(T item, void (*removeItemData)(T))
+{
+    int index = indexOf(item);
+    if (index == -1)
+        return false;
+    if (removeItemData != 0)
+        removeItemData(this->data[index]);
+    removeAt(index);
+    return true;
+}
+
+template <class T>
+void XIndexedList<T>::clear()
+{
+    XArrayList<T>::clear();
+    allocateSlots(0);
+}
+
+template <class T>
+int XIndexedList<T>::indexOf(T item)
+{
+    size_t h = hashItem(item, itemHash);
+    int mask = slotCapacity - 1;
+    int found = -1;
+    // duplicates are allowed: scan the whole cluster, keep the first position
+    for (int i = (int)(h & mask); slotPos[i] != EMPTY; i = (i + 1) & mask)
+    {
+        int pos = slotPos[i];
+        if (pos >= 0 && slotHash[i] == h && (found == -1 || pos < found) &&
+            XArrayList<T>::equals(this->data[pos], item, this->itemEqual))
+            found = pos;
+    }
+    return found;
+}
+
+template <class T>
+bool XIndexedList<T>::contains(T item)
+{
+    return indexOf(item) != -1;
+}
+
+template <class T>
+void XIndexedList<T>::reindex()
+{
+    allocateSlots(this->count);
+    for (int pos = 0; pos < this->count; pos++)
+        linkSlot(pos);
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+template <class T>
+int XIndexedList<T>::findSlot(int pos)
+{
+    /**
+     * Returns the slot storing position "pos"; the item at "pos" must be in the index.
+     */
+    int mask = slotCapacity - 1;
+    int i = (int)(hashItem(this->data[pos], itemHash) & mask);
+    while (slotPos[i] != pos)
+        i = (i + 1) & mask;
+    return i;
+}
+
+template <class T>
+void XIndexedList<T>::linkSlot(int pos)
+{
+    /**
+     * Inserts position "pos" into the index; grows the slot table to keep the load factor <= 1/2.
+     */
+    if (2 * (slotUsed + 1) > slotCapacity)
+    {
+        // rebuild from the array: positions >= pos are not in the index yet
+        allocateSlots(this->count);
+        for (int p = 0; p < this->count; p++)
+            if (p != pos)
+                linkSlot(p);
+    }
+    size_t h = hashItem(this->data[pos], itemHash);
+    int mask = slotCapacity - 1;
+    int i = (int)(h & mask);
+    while (slotPos[i] >= 0)
+        i = (i + 1) & mask;
+    if (slotPos[i] == EMPTY)
+        slotUsed++;
+    slotPos[i] = pos;
+    slotHash[i] = h;
+}
+
+template <class T>
+void XIndexedList<T>::allocateSlots(int minItems)
+{
+    removeIndexData();
+    slotCapacity = 16;
+    while (slotCapacity < 4 * minItems)
+        slotCapacity *= 2;
+    slotPos = new int[slotCapacity];
+    slotHash = new size_t[slotCapacity];
+    for (int i = 0; i < slotCapacity; i++)
+        slotPos[i] = EMPTY;
+    slotUsed = 0;
+}
+
+template <class T>
+void XIndexedList<T>::removeIndexData()
+{
+    delete[] slotPos;
+    delete[] slotHash;
+    slotPos = 0;
+    slotHash = 0;
+    slotCapacity = 0;
+    slotUsed = 0;
+}
+
+#endif /* XINDEXEDLIST_H */
@@ -0,0 +1,214 @@
+/*
+ * File:   XSortedArrayList.h
+ */
+
+#ifndef XSORTEDARRAYLIST_H
+#define XSORTEDARRAYLIST_H
+#include "XArrayList.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <stdexcept>
+using namespace std;
+
+/* XSortedArrayList<T>:
+ *  + an XArrayList that keeps its items in increasing order (see: compare)
+ *  + indexOf, contains, removeItem: binary search, O(log n) to locate the item
+ *  + add(e): insert e at its lower bound, the tail is shifted by one memmove
+ *  + addAll(items, n): sort the batch, then merge it into the list in one linear pass
+ *  + add(index, e): not supported (the order decides the position), see below
+ *
+ * NOTE: do not change the order of an item via get(index) or via Iterator
+ */
+template <class T>
+class XSortedArrayList : public XArrayList<T>
+{
+protected:
+    int (*comparator)(T &lhs, T &rhs); // function pointer: compare two items (see: compare)
+
+public:
+    XSortedArrayList(
+        int (*comparator)(T &, T &) = 0,
+        void (*deleteUserData)(XArrayList<T> *) = 0,
+        int capacity = 10) : XArrayList<T>(deleteUserData, 0, capacity)
+    {
+        this->comparator = comparator;
+    }
+
+    void add(T e);
+    /* add(int index, T e): a sorted list cannot insert at a given position
+     *  >> throw an exception (std::logic_error); use add(e)
+     */
+    void add(int index, T e);
+    bool removeItem(T item, void (*removeItemData)(T) = 0);
+    int indexOf(T item);
+    bool contains(T item);
+
+    /* addAll(T* items, int n): insert n items in O(n log n + size())
+     *      instead of n insertions (each one shifting the tail)
+     */
+    void addAll(T *items, int n);
+    void addAll(XArrayList<T> &list);
+
+    /* lowerBound(T item): index of the first item >= "item" (size() if none)
+     * upperBound(T item): index of the first item > "item" (size() if none)
+     */
+    int lowerBound(T &item);
+    int upperBound(T &item);
+
+protected:
+    /** compare:
+     * if comparator == 0: use native operator < (class of type T MUST override operator <)
+     *      return -1 if lhs < rhs, +1 if rhs < lhs, 0 otherwise
+     * else: return comparator(lhs, rhs)
+     */
+    static int compare(T &lhs, T &rhs, int (*comparator)(T &, T &))
+    {
+        if (comparator == 0)
+        {
+            if (lhs < rhs)
+                return -1;
+            else if (rhs < lhs)
+                return +1;
+            else
+                return 0;
+        }
+        else
+            return comparator(lhs, rhs);
+    }
+
+    /* shiftRight(index): move data[index..count-1] to data[index+1..count]
+     *      memmove if T can be copied bit by bit, else element by element
+     */
+    void shiftRight(int index)
+    {
+        shiftRight(index, typename std::is_trivially_copyable<T>::type());
+    }
+    void shiftRight(int index, std::true_type)
+    {
+        memmove(this->data + index + 1, this->data + index, (this->count - index) * sizeof(T));
+    }
+    void shiftRight(int index, std::false_type)
+    {
+        std::move_backward(this->data + index, this->data + this->count, this->data + this->count + 1);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+void XSortedArrayList<T>::add(T e)
+{
+    int index = lowerBound(e);
+    try {
+        this->ensureCapacity(this->count);
+    }
+    catch (...) { return; }
+    shiftRight(index);
+    this->data[index] = e;
+    this->count++;
+}
+
+template <class T>
+void XSortedArrayList<T>::add(int, T)
+{
+    throw std::logic_error("XSortedArrayList cannot insert at a position, use add(e)!");
+}
+
+template <class T>
+bool XSortedArrayList<T>::removeItem(T item, void (*removeItemData)(T))
+{
+    int index = indexOf(item);
+    if (index == -1)
+        return false;
+    if (removeItemData != 0)
+        removeItemData(this->data[index]);
+    this->removeAt(index);
+    return true;
+}
+
+template <class T>
+int XSortedArrayList<T>::indexOf(T item)
+{
+    int index = lowerBound(item);
+    if (index < this->count && compare(this->data[index], item, comparator) == 0)
+        return index;
+    return -1;
+}
+
+template <class T>
+bool XSortedArrayList<T>::contains(T item)
+{
+    return indexOf(item) != -1;
+}
+
+template <class T>
+void XSortedArrayList<T>::addAll(T *items, int n)
+{
+    if (n <= 0)
+        return;
+    T *batch = new T[n];
+    for (int i = 0; i < n; i++)
+        batch[i] = items[i];
+    int (*comparator)(T &, T &) = this->comparator;
+    std::sort(batch, batch + n, [comparator](T &lhs, T &rhs) {
+        return compare(lhs, rhs, comparator) < 0;
+    });
+    this->reserve(this->count + n);
+    // merge from the back: every item is moved once, the list items need no extra buffer
+    int i = this->count - 1, j = n - 1, k = this->count + n - 1;
+    while (j >= 0)
+    {
+        if (i >= 0 && compare(batch[j], this->data[i], comparator) < 0)
+            this->data[k--] = this->data[i--];
+        else
+            this->data[k--] = batch[j--];
+    }
+    this->count += n;
+    delete[] batch;
+}
+
+template <class T>
+void XSortedArrayList<T>::addAll(XArrayList<T> &list)
+{
+    T *items = new T[list.size() + 1];
+    int n = 0;
+    for (typename XArrayList<T>::Iterator it = list.begin(); it != list.end(); it++)
+        items[n++] = *it;
+    addAll(items, n);
+    delete[] items;
+}
+
+template <class T>
+int XSortedArrayList<T>::lowerBound(T &item)
+{
+    int lo = 0, hi = this->count;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (compare(this->data[mid], item, comparator) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+template <class T>
+int XSortedArrayList<T>::upperBound(T &item)
+{
+    int lo = 0, hi = this->count;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (compare(item, this->data[mid], comparator) < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+#endif /* XSORTEDARRAYLIST_H */
@@ -0,0 +1,652 @@
+/*
+ * File:   XTreeMap.h
+ */
+
+#ifndef XTREEMAP_H
+#define XTREEMAP_H
+#include "XArrayList.h"
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+using namespace std;
+
+/* XTreeMap<K, V>:
+ *  + ordered map implemented by an AVL tree
+ *      (the heights of the two subtrees of any node differ by at most 1)
+ *  + put, remove, get, containsKey, lowerBound, upperBound: O(log n)
+ *  + Iterator: traverse the entries in increasing order of keys
+ *  + range(lo, hi, visit): visit the entries with lo <= key < hi in O(log n + k)
+ */
+template <class K, class V>
+class XTreeMap
+{
+public:
+    class Node;     // forward declaration
+    class Iterator; // forward declaration
+
+protected:
+    Node *root;
+    int count;
+    int (*keyCompare)(K &lhs, K &rhs);      // function pointer: compare two keys (see: compare)
+    void (*deleteKeys)(XTreeMap<K, V> *);   // function pointer: be called to remove keys (if they are pointer type)
+    void (*deleteValues)(XTreeMap<K, V> *); // function pointer: be called to remove values (if they are pointer type)
+
+public:
+    XTreeMap(
+        void (*deleteKeys)(XTreeMap<K, V> *) = 0,
+        void (*deleteValues)(XTreeMap<K, V> *) = 0,
+        int (*keyCompare)(K &, K &) = 0);
+    XTreeMap(const XTreeMap<K, V> &map);
+    XTreeMap<K, V> &operator=(const XTreeMap<K, V> &map);
+    ~XTreeMap();
+
+    /* put(K key, V value): insert (key, value); if key exists, replace its value
+     * return:
+     *  >> the old value if key exists; otherwise, value
+     */
+    V put(K key, V value);
+
+    /* get(K key): return a reference to the value of key
+     *  >> throw an exception (std::out_of_range) if key is not found
+     */
+    V &get(K key);
+
+    /* remove(K key, void (*deleteKeyInMap)(K)=0): remove the entry of key
+     * return:
+     *  >> the value of key
+     *  >> throw an exception (std::out_of_range) if key is not found
+     */
+    V remove(K key, void (*deleteKeyInMap)(K) = 0);
+
+    bool containsKey(K key);
+    bool empty();
+    int size();
+    int height();
+    void clear();
+
+    /* lowerBound(K key): iterator to the first entry with key >= "key" (end() if none)
+     * upperBound(K key): iterator to the first entry with key > "key" (end() if none)
+     */
+    Iterator lowerBound(K key);
+    Iterator upperBound(K key);
+
+    /* range(K lo, K hi, visit): call visit(key, value) for every entry with lo <= key < hi,
+     *      in increasing order of keys
+     * return:
+     *  >> the number of visited entries
+     */
+    int range(K lo, K hi, void (*visit)(K &, V &) = 0);
+
+    XArrayList<K> keys();
+    XArrayList<V> values();
+
+    string toString(string (*key2str)(K &) = 0, string (*value2str)(V &) = 0);
+    void println(string (*key2str)(K &) = 0, string (*value2str)(V &) = 0)
+    {
+        cout << toString(key2str, value2str) << endl;
+    }
+
+    Iterator begin()
+    {
+        return Iterator(this, leftmost(root));
+    }
+    Iterator end()
+    {
+        return Iterator(this, 0);
+    }
+
+    /** freeKey, freeValue:
+     * if K (or V) is pointer type:
+     *     pass THE address of freeKey (or freeValue) to XTreeMap<K, V>'s constructor
+     */
+    static void freeKey(XTreeMap<K, V> *map)
+    {
+        for (typename XTreeMap<K, V>::Iterator it = map->begin(); it != map->end(); it++)
+            delete (*it).key;
+    }
+    static void freeValue(XTreeMap<K, V> *map)
+    {
+        for (typename XTreeMap<K, V>::Iterator it = map->begin(); it != map->end(); it++)
+            delete (*it).value;
+    }
+
+protected:
+    /** compare:
+     * if keyCompare == 0: use native operator < (class of type K MUST override operator <)
+     *      return -1 if lhs < rhs, +1 if rhs < lhs, 0 otherwise
+     * else: return keyCompare(lhs, rhs)
+     */
+    static int compare(K &lhs, K &rhs, int (*keyCompare)(K &, K &))
+    {
+        if (keyCompare == 0)
+        {
+            if (lhs < rhs)
+                return -1;
+            else if (rhs < lhs)
+                return +1;
+            else
+                return 0;
+        }
+        else
+            return keyCompare(lhs, rhs);
+    }
+    static int heightOf(Node *node) { return node == 0 ? 0 : node->height; }
+    static void update(Node *node);
+    static Node *leftmost(Node *node);
+    static Node *successor(Node *node);
+    Node *find(K &key);
+    Node *rotateLeft(Node *node);
+    Node *rotateRight(Node *node);
+    Node *rebalance(Node *node);
+    Node *insert(Node *node, K &key, V &value, V &old, bool &found);
+    Node *erase(Node *node, K &key, V &value, void (*deleteKeyInMap)(K), bool &found);
+    Node *eraseMin(Node *node, Node *&min);
+    Node *copyTree(Node *node, Node *parent);
+    void removeTree(Node *node);
+    void removeInternalData();
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    class Node
+    {
+    public:
+        K key;
+        V value;
+        Node *left;
+        Node *right;
+        Node *parent;
+        int height;
+        friend class XTreeMap<K, V>;
+
+    public:
+        Node(K key, V value, Node *parent = 0) : key(key), value(value)
+        {
+            this->left = 0;
+            this->right = 0;
+            this->parent = parent;
+            this->height = 1;
+        }
+    };
+
+    // Iterator: BEGIN
+    class Iterator
+    {
+    private:
+        XTreeMap<K, V> *pMap;
+        Node *pNode;
+
+    public:
+        Iterator(XTreeMap<K, V> *pMap = 0, Node *pNode = 0)
+        {
+            this->pMap = pMap;
+            this->pNode = pNode;
+        }
+        // NOTE: do not change the key, only the value
+        Node &operator*()
+        {
+            return *pNode;
+        }
+        bool operator!=(const Iterator &iterator)
+        {
+            return pNode != iterator.pNode;
+        }
+        // Prefix ++ overload
+        Iterator &operator++()
+        {
+            pNode = XTreeMap<K, V>::successor(pNode);
+            return *this;
+        }
+        // Postfix ++ overload
+        Iterator operator++(int)
+        {
+            Iterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+    };
+    // Iterator: END
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class K, class V>
+XTreeMap<K, V>::XTreeMap(
+    void (*deleteKeys)(XTreeMap<K, V> *),
+    void (*deleteValues)(XTreeMap<K, V> *),
+    int (*keyCompare)(K &, K &))
+{
+    root = 0;
+    count = 0;
+    this->deleteKeys = deleteKeys;
+    this->deleteValues = deleteValues;
+    this->keyCompare = keyCompare;
+}
+
+template <class K, class V>
+XTreeMap<K, V>::XTreeMap(const XTreeMap<K, V> &map)
+{
+    root = copyTree(map.root, 0);
+    count = map.count;
+    deleteKeys = map.deleteKeys;
+    deleteValues = map.deleteValues;
+    keyCompare = map.keyCompare;
+}
+
+template <class K, class V>
+XTreeMap<K, V> &XTreeMap<K, V>::operator=(const XTreeMap<K, V> &map)
+{
+    if (this != &map)
+    {
+        removeInternalData();
+        root = copyTree(map.root, 0);
+        count = map.count;
+        deleteKeys = map.deleteKeys;
+        deleteValues = map.deleteValues;
+        keyCompare = map.keyCompare;
+    }
+    return *this;
+}
+
+template <class K, class V>
+XTreeMap<K, V>::~XTreeMap()
+{
+    removeInternalData();
+}
+
+template <class K, class V>
+V XTreeMap<K, V>::put(K key, V value)
+{
+    V old = value;
+    bool found = false;
+    root = insert(root, key, value, old, found);
+    root->parent = 0;
+    if (!found)
+        count++;
+    return old;
+}
+
+template <class K, class V>
+V &XTreeMap<K, V>::get(K key)
+{
+    Node *node = find(key);
+    if (node == 0)
+        throw out_of_range("Key is not found!");
+    return node->value;
+}
+
+template <class K, class V>
+V XTreeMap<K, V>::remove(K key, void (*deleteKeyInMap)(K))
+{
+    V value = V();
+    bool found = false;
+    root = erase(root, key, value, deleteKeyInMap, found);
+    if (!found)
+        throw out_of_range("Key is not found!");
+    if (root != 0)
+        root->parent = 0;
+    count--;
+    return value;
+}
+
+template <class K, class V>
+bool XTreeMap<K, V>::containsKey(K key)
+{
+    return find(key) != 0;
+}
+
+template <class K, class V>
+bool XTreeMap<K, V>::empty()
+{
+    return count == 0;
+}
+
+template <class K, class V>
+int XTreeMap<K, V>::size()
+{
+    return count;
+}
+
+template <class K, class V>
+int XTreeMap<K, V>::height()
+{
+    return heightOf(root);
+}
+
+template <class K, class V>
+void XTreeMap<K, V>::clear()
+{
+    removeInternalData();
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Iterator XTreeMap<K, V>::lowerBound(K key)
+{
+    Node *node = root, *result = 0;
+    while (node != 0)
+    {
+        if (compare(node->key, key, keyCompare) >= 0)
+        {
+            result = node;
+            node = node->left;
+        }
+        else
+            node = node->right;
+    }
+    return Iterator(this, result);
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Iterator XTreeMap<K, V>::upperBound(K key)
+{
+    Node *node = root, *result = 0;
+    while (node != 0)
+    {
+        if (compare(node->key, key, keyCompare) > 0)
+        {
+            result = node;
+            node = node->left;
+        }
+        else
+            node = node->right;
+    }
+    return Iterator(this, result);
+}
+
+template <class K, class V>
+int XTreeMap<K, V>::range(K lo, K hi, void (*visit)(K &, V &))
+{
+    int visited = 0;
+    for (Iterator it = lowerBound(lo); it != end(); it++)
+    {
+        if (compare((*it).key, hi, keyCompare) >= 0)
+            break;
+        if (visit != 0)
+            visit((*it).key, (*it).value);
+        visited++;
+    }
+    return visited;
+}
+
+template <class K, class V>
+XArrayList<K> XTreeMap<K, V>::keys()
+{
+    XArrayList<K> result(0, 0, count + 1);
+    for (Iterator it = begin(); it != end(); it++)
+        result.add((*it).key);
+    return result;
+}
+
+template <class K, class V>
+XArrayList<V> XTreeMap<K, V>::values()
+{
+    XArrayList<V> result(0, 0, count + 1);
+    for (Iterator it = begin(); it != end(); it++)
+        result.add((*it).value);
+    return result;
+}
+
+template <class K, class V>
+string XTreeMap<K, V>::toString(string (*key2str)(K &), string (*value2str)(V &))
+{
+    /**
+     * Converts the map into a string, in increasing order of keys: {key1: value1, key2: value2, ...}
+     */
+    stringstream ss;
+    ss << "{";
+    bool first = true;
+    for (Iterator it = begin(); it != end(); it++)
+    {
+        if (!first)
+            ss << ", ";
+        first = false;
+        if (key2str != 0)
+            ss << key2str((*it).key);
+        else
+            ss << (*it).key;
+        ss << ": ";
+        if (value2str != 0)
+            ss << value2str((*it).value);
+        else
+            ss << (*it).value;
+    }
+    ss << "}";
+    return ss.str();
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+template <class K, class V>
+void XTreeMap<K, V>::update(Node *node)
+{
+    int hl = heightOf(node->left), hr = heightOf(node->right);
+    node->height = (hl > hr ? hl : hr) + 1;
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::leftmost(Node *node)
+{
+    if (node == 0)
+        return 0;
+    while (node->left != 0)
+        node = node->left;
+    return node;
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::successor(Node *node)
+{
+    /**
+     * Returns the next node in increasing order of keys (0 after the last one):
+     * the leftmost node of the right subtree, or the first ancestor reached from its left subtree.
+     */
+    if (node->right != 0)
+        return leftmost(node->right);
+    Node *parent = node->parent;
+    while (parent != 0 && node == parent->right)
+    {
+        node = parent;
+        parent = parent->parent;
+    }
+    return parent;
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::find(K &key)
+{
+    Node *node = root;
+    while (node != 0)
+    {
+        int c = compare(key, node->key, keyCompare);
+        if (c == 0)
+            return node;
+        node = c < 0 ? node->left : node->right;
+    }
+    return 0;
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::rotateLeft(Node *node)
+{
+    Node *pivot = node->right;
+    node->right = pivot->left;
+    if (pivot->left != 0)
+        pivot->left->parent = node;
+    pivot->left = node;
+    pivot->parent = node->parent;
+    node->parent = pivot;
+    update(node);
+    update(pivot);
+    return pivot;
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::rotateRight(Node *node)
+{
+    Node *pivot = node->left;
+    node->left = pivot->right;
+    if (pivot->right != 0)
+        pivot->right->parent = node;
+    pivot->right = node;
+    pivot->parent = node->parent;
+    node->parent = pivot;
+    update(node);
+    update(pivot);
+    return pivot;
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::rebalance(Node *node)
+{
+    /**
+     * Restores the AVL property at node (its subtrees are already balanced);
+     * returns the new root of the subtree.
+     */
+    update(node);
+    int balance = heightOf(node->left) - heightOf(node->right);
+    if (balance > 1)
+    {
+        if (heightOf(node->left->left) < heightOf(node->left->right))
+            node->left = rotateLeft(node->left); // left-right case
+        return rotateRight(node);
+    }
+    if (balance < -1)
+    {
+        if (heightOf(node->right->right) < heightOf(node->right->left))
+            node->right = rotateRight(node->right); // right-left case
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::insert(Node *node, K &key, V &value, V &old, bool &found)
+{
+    if (node == 0)
+        return new Node(key, value);
+    int c = compare(key, node->key, keyCompare);
+    if (c == 0)
+    {
+        found = true;
+        old = node->value;
+        node->value = value;
+        return node;
+    }
+    if (c < 0)
+    {
+        node->left = insert(node->left, key, value, old, found);
+        node->left->parent = node;
+    }
+    else
+    {
+        node->right = insert(node->right, key, value, old, found);
+        node->right->parent = node;
+    }
+    return found ? node : rebalance(node);
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::eraseMin(Node *node, Node *&min)
+{
+    /**
+     * Detaches the leftmost node of the subtree into "min"; returns the new root of the subtree.
+     */
+    if (node->left == 0)
+    {
+        min = node;
+        if (node->right != 0)
+            node->right->parent = node->parent;
+        return node->right;
+    }
+    node->left = eraseMin(node->left, min);
+    if (node->left != 0)
+        node->left->parent = node;
+    return rebalance(node);
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::erase(Node *node, K &key, V &value, void (*deleteKeyInMap)(K), bool &found)
+{
+    if (node == 0)
+        return 0;
+    int c = compare(key, node->key, keyCompare);
+    if (c < 0)
+    {
+        node->left = erase(node->left, key, value, deleteKeyInMap, found);
+        if (node->left != 0)
+            node->left->parent = node;
+    }
+    else if (c > 0)
+    {
+        node->right = erase(node->right, key, value, deleteKeyInMap, found);
+        if (node->right != 0)
+            node->right->parent = node;
+    }
+    else
+    {
+        found = true;
+        value = node->value;
+        if (deleteKeyInMap != 0)
+            deleteKeyInMap(node->key);
+        Node *replace;
+        if (node->left == 0 || node->right == 0)
+            replace = node->left != 0 ? node->left : node->right;
+        else
+        {
+            // relink the successor in place of node (nodes are not copied: iterators to other entries stay valid)
+            Node *min;
+            Node *right = eraseMin(node->right, min);
+            min->left = node->left;
+            min->right = right;
+            node->left->parent = min;
+            if (right != 0)
+                right->parent = min;
+            replace = rebalance(min);
+        }
+        if (replace != 0)
+            replace->parent = node->parent;
+        delete node;
+        return replace;
+    }
+    return found ? rebalance(node) : node;
+}
+
+template <class K, class V>
+typename XTreeMap<K, V>::Node *XTreeMap<K, V>::copyTree(Node *node, Node *parent)
+{
+    if (node == 0)
+        return 0;
+    Node *copy = new Node(node->key, node->value, parent);
+    copy->height = node->height;
+    copy->left = copyTree(node->left, copy);
+    copy->right = copyTree(node->right, copy);
+    return copy;
+}
+
+template <class K, class V>
+void XTreeMap<K, V>::removeTree(Node *node)
+{
+    if (node == 0)
+        return;
+    removeTree(node->left);
+    removeTree(node->right);
+    delete node;
+}
+
+template <class K, class V>
+void XTreeMap<K, V>::removeInternalData()
+{
+    if (deleteKeys != 0)
+        deleteKeys(this);
+    if (deleteValues != 0)
+        deleteValues(this);
+    removeTree(root);
+    root = 0;
+    count = 0;
+}
+
+#endif /* XTREEMAP_H */
@@ -0,0 +1,91 @@
+/*
+ * File:   XTreeMapDemo.h
+ */
+
+#ifndef XTREEMAPDEMO_H
+#define XTREEMAPDEMO_H
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include "XArrayList.h"
+#include "XTreeMap.h"
+using namespace std;
+
+void treeMapDemo1(){
+    XTreeMap<int, string> map;
+    map.put(50, "fifty");
+    map.put(20, "twenty");
+    map.put(80, "eighty");
+    map.put(10, "ten");
+    map.put(30, "thirty");
+    map.println();
+
+    cout << "lowerBound(25): " << (*map.lowerBound(25)).key << endl;
+    cout << "keys in [20, 80): ";
+    for(XTreeMap<int, string>::Iterator it = map.lowerBound(20); it != map.end() && (*it).key < 80; it++)
+        cout << (*it).key << " ";
+    cout << endl;
+    map.remove(20);
+    map.println();
+}
+
+/* treeMapBenchmark(int nitems):
+ *  insert nitems random keys into
+ *  (1) a sorted XArrayList: binary search for the position, then add(index, e) shifts the tail: O(n) per insert
+ *  (2) an XTreeMap: O(log n) per insert
+ *  then run nitems lookups and one range scan on both
+ */
+void treeMapBenchmark(int nitems = 100000){
+    std::default_random_engine engine(2024);
+    uniform_int_distribution<int> dist(0, 10 * nitems);
+    int* keys = new int[nitems];
+    for(int idx=0; idx < nitems; idx++) keys[idx] = dist(engine);
+
+    auto start = chrono::steady_clock::now();
+    XArrayList<int> sorted(0, 0, nitems);
+    for(int idx=0; idx < nitems; idx++){
+        int lo = 0, hi = sorted.size();
+        while(lo < hi){
+            int mid = (lo + hi) / 2;
+            if(sorted.get(mid) < keys[idx]) lo = mid + 1;
+            else hi = mid;
+        }
+        if(lo == sorted.size() || sorted.get(lo) != keys[idx]) sorted.add(lo, keys[idx]);
+    }
+    auto middle = chrono::steady_clock::now();
+    XTreeMap<int, int> tree;
+    for(int idx=0; idx < nitems; idx++) tree.put(keys[idx], idx);
+    auto stop = chrono::steady_clock::now();
+    cout << "insert " << nitems << " keys:" << endl;
+    cout << "  sorted XArrayList: " << setw(8) << chrono::duration_cast<chrono::milliseconds>(middle - start).count() << " ms" << endl;
+    cout << "  XTreeMap:          " << setw(8) << chrono::duration_cast<chrono::milliseconds>(stop - middle).count() << " ms" << endl;
+
+    int found1 = 0, found2 = 0;
+    start = chrono::steady_clock::now();
+    for(int idx=0; idx < nitems; idx++){
+        int lo = 0, hi = sorted.size();
+        while(lo < hi){
+            int mid = (lo + hi) / 2;
+            if(sorted.get(mid) < idx) lo = mid + 1;
+            else hi = mid;
+        }
+        if(lo < sorted.size() && sorted.get(lo) == idx) found1++;
+    }
+    middle = chrono::steady_clock::now();
+    for(int idx=0; idx < nitems; idx++)
+        if(tree.containsKey(idx)) found2++;
+    stop = chrono::steady_clock::now();
+    cout << "lookup " << nitems << " keys (found: " << found1 << ", " << found2 << "):" << endl;
+    cout << "  sorted XArrayList: " << setw(8) << chrono::duration_cast<chrono::milliseconds>(middle - start).count() << " ms" << endl;
+    cout << "  XTreeMap:          " << setw(8) << chrono::duration_cast<chrono::milliseconds>(stop - middle).count() << " ms" << endl;
+
+    start = chrono::steady_clock::now();
+    int scanned = tree.range(nitems, 2 * nitems);
+    stop = chrono::steady_clock::now();
+    cout << "range scan [" << nitems << ", " << 2 * nitems << "): " << scanned << " entries, "
+         << chrono::duration_cast<chrono::microseconds>(stop - start).count() << " us" << endl;
+    delete[] keys;
+}
+
+#endif /* XTREEMAPDEMO_H */
@@ -0,0 +1,148 @@
+/*
+ * File:   cacheddataset.h
+ */
+
+#ifndef CACHEDDATASET_H
+#define CACHEDDATASET_H
+#include "xtensor_lib.h"
+#include "dataset.h"
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+using namespace std;
+
+/* CachedDataset: keeps the samples returned by another dataset, so that getitem(i) is computed once
+ *      (e.g., a dataset that decodes files in getitem: the epochs after the first one read memory)
+ *  + LRU cache of at most memory_budget bytes (data + label of the samples);
+ *      a sample larger than the budget of its shard is not kept
+ *  + the cache is split into num_shards shards (sample i in shard i % num_shards), each with its
+ *      own lock and 1/num_shards of the budget => DataLoader workers rarely wait for each other
+ *  + a miss calls dataset->getitem without holding a lock; two threads that miss the same sample
+ *      may both compute it (the first result is kept)
+ *  + cache_hits(), cache_misses(): counters over all shards
+ *  + the dataset is not owned: it must outlive the cache
+ *  + len() is the length of the dataset when the cache is built
+ * NOTE: the samples must not depend on the epoch (e.g., random augmentation): they would be frozen
+ */
+template<typename DType, typename LType>
+class CachedDataset: public Dataset<DType, LType>{
+private:
+    typedef std::shared_ptr<const DataLabel<DType, LType>> Item;
+    struct Shard{
+        std::mutex mutex;
+        std::list<int> recent;                          //most recently used first
+        std::vector<Item> items;                        //items[i / num_shards]: null if not cached
+        std::vector<std::list<int>::iterator> position;
+        size_t bytes;
+        long hits, misses;
+        Shard(): bytes(0), hits(0), misses(0){}
+    };
+    Dataset<DType, LType>* dataset;
+    int num_shards, size;
+    size_t shard_budget;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+public:
+    CachedDataset(Dataset<DType, LType>* dataset, size_t memory_budget, int num_shards = 16):
+    dataset(dataset), num_shards(num_shards){
+        if (num_shards < 1) throw std::invalid_argument("num_shards must be >= 1!");
+        shard_budget = memory_budget / num_shards;
+        size = dataset->len();
+        for (int k = 0; k < num_shards; k++) {
+            shards.push_back(std::unique_ptr<Shard>(new Shard()));
+            int count = size / num_shards + (k < size % num_shards);
+            shards[k]->items.resize(count);
+            shards[k]->position.resize(count);
+        }
+    }
+    CachedDataset(const CachedDataset& dataset) = delete;
+    CachedDataset& operator=(const CachedDataset& dataset) = delete;
+
+    int len(){ return size; }
+
+    DataLabel<DType, LType> getitem(int index){
+        if (index < 0 || index >= len())
+            throw out_of_range("Index is out of range!");
+        Shard& shard = *shards[index % num_shards];
+        int slot = index / num_shards;
+        Item item;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.items[slot]) {
+                shard.hits++;
+                shard.recent.splice(shard.recent.begin(), shard.recent, shard.position[slot]);
+                item = shard.items[slot];
+            }
+            else shard.misses++;
+        }
+        if (item) return *item;     //the copy is made outside the lock
+
+        item = std::make_shared<const DataLabel<DType, LType>>(dataset->getitem(index));
+        size_t bytes = item->getData().size() * sizeof(DType) + item->getLabel().size() * sizeof(LType);
+        if (bytes > shard_budget) return *item;
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (!shard.items[slot]) {
+            while (shard.bytes + bytes > shard_budget) evict(shard);
+            shard.recent.push_front(slot);
+            shard.position[slot] = shard.recent.begin();
+            shard.items[slot] = item;
+            shard.bytes += bytes;
+        }
+        return *item;
+    }
+
+    xt::svector<unsigned long> get_data_shape(){ return dataset->get_data_shape(); }
+    xt::svector<unsigned long> get_label_shape(){ return dataset->get_label_shape(); }
+
+    long cache_hits(){
+        long total = 0;
+        for (int k = 0; k < num_shards; k++) {
+            std::lock_guard<std::mutex> lock(shards[k]->mutex);
+            total += shards[k]->hits;
+        }
+        return total;
+    }
+    long cache_misses(){
+        long total = 0;
+        for (int k = 0; k < num_shards; k++) {
+            std::lock_guard<std::mutex> lock(shards[k]->mutex);
+            total += shards[k]->misses;
+        }
+        return total;
+    }
+    /* cache_bytes(): memory held by the cached samples
+     */
+    size_t cache_bytes(){
+        size_t total = 0;
+        for (int k = 0; k < num_shards; k++) {
+            std::lock_guard<std::mutex> lock(shards[k]->mutex);
+            total += shards[k]->bytes;
+        }
+        return total;
+    }
+    /* clear(): drop every cached sample (e.g., the samples of the source dataset have changed);
+     *      counters are kept; a source with a new length needs a new CachedDataset
+     */
+    void clear(){
+        for (int k = 0; k < num_shards; k++) {
+            std::lock_guard<std::mutex> lock(shards[k]->mutex);
+            while (!shards[k]->recent.empty()) evict(*shards[k]);
+        }
+    }
+
+private:
+    /* evict(shard): drop the least recently used sample of shard (its lock is held)
+     */
+    void evict(Shard& shard){
+        int slot = shard.recent.back();
+        const Item& item = shard.items[slot];
+        shard.bytes -= item->getData().size() * sizeof(DType) + item->getLabel().size() * sizeof(LType);
+        shard.items[slot].reset();
+        shard.recent.pop_back();
+    }
+};
+
+#endif /* CACHEDDATASET_H */
@@ -0,0 +1,259 @@
+/*
+ * File:   chunkeddataset.h
+ */
+
+#ifndef CHUNKEDDATASET_H
+#define CHUNKEDDATASET_H
+#include "xtensor_lib.h"
+#include "dataset.h"
+#include "sharddataset.h"
+#include <fstream>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+using namespace std;
+
+/* write_chunks(dataset, prefix, chunk_rows): dump dataset into chunk files of chunk_rows samples
+ *      (the last one may be shorter): prefix-00000.shard, prefix-00001.shard, ...
+ *      return their paths (see: ChunkedTensorDataset)
+ */
+template<typename DType, typename LType>
+std::vector<string> write_chunks(Dataset<DType, LType>* dataset, string prefix, int chunk_rows){
+    if (chunk_rows < 1) throw std::invalid_argument("chunk_rows must be >= 1!");
+    std::vector<string> paths;
+    int size = dataset->len();
+    for (int first = 0, k = 0; first < size; first += chunk_rows, k++) {
+        paths.push_back(shard_path(prefix, k));
+        write_shard(dataset, paths.back(), first, std::min(chunk_rows, size - first));
+    }
+    return paths;
+}
+
+//////////////////////////////////////////////////////////////////////
+/* ChunkedTensorDataset: a dataset larger than memory, stored as chunk files of consecutive rows
+ *      (shard files, see: write_chunks), loaded on demand
+ *  + only the headers are read when opening; a chunk is read (one sequential read) when one of its
+ *      samples is needed, and kept in an LRU cache of at most memory_budget bytes (at least one chunk)
+ *  + DataLoader shuffles it chunk by chunk (see: ChunkedRows, ChunkSampler):
+ *      each pass reads every chunk once, as long as window_chunks() chunks fit in the budget
+ *  + thread-safe: a chunk stays alive while a sample is copied out of it, even if it is evicted;
+ *      a chunk is read without holding the cache lock (the other threads go on with the cached
+ *      chunks), and the threads that need a chunk being read wait for that one read
+ *  + every chunk but the last one must have the same number of rows
+ *  >> throw an exception (std::runtime_error) if a file is not a shard of DType/LType,
+ *      or if the chunks have different sample shapes or sizes
+ */
+template<typename DType, typename LType>
+class ChunkedTensorDataset: public Dataset<DType, LType>, public ChunkedRows{
+private:
+    struct Chunk{
+        xt::xarray<DType> data;
+        xt::xarray<LType> label;
+    };
+    std::vector<string> paths;
+    std::vector<uint64_t> index_offsets;    //index_offsets[k]: file offset of the index of chunk k
+    std::vector<int> counts;                //counts[k]: number of rows in chunk k
+    int rows_per_chunk, size;
+    xt::svector<unsigned long> data_shape, label_shape;
+    size_t data_row, label_row;             //number of elements in one sample
+    bool labelled;
+    size_t max_chunks;
+    //LRU cache: recent = chunk ids, most recently used first; cached[k] == null: chunk k not loaded
+    std::mutex cache_mutex;
+    std::list<int> recent;
+    std::vector<std::shared_ptr<Chunk>> cached;
+    std::vector<std::list<int>::iterator> position;
+    std::vector<std::shared_future<std::shared_ptr<Chunk>>> loading;     //valid: chunk k is being read
+    long hits, misses;
+
+public:
+    ChunkedTensorDataset(std::vector<string> paths, size_t memory_budget = (size_t)256 << 20):
+    paths(paths), rows_per_chunk(0), size(0), data_row(1), label_row(0), labelled(false), hits(0), misses(0){
+        if (paths.empty()) throw std::invalid_argument("ChunkedTensorDataset needs at least one file!");
+        for (size_t k = 0; k < paths.size(); k++) {
+            std::ifstream stream(paths[k], std::ios::binary);
+            if (!stream) throw std::runtime_error("Cannot open file: " + paths[k]);
+            ShardHeader header;
+            xt::svector<unsigned long> data_dims, label_dims;
+            read_shard_header<DType, LType>(stream, paths[k], header, data_dims, label_dims);
+            if (k == 0) {
+                data_shape = data_dims;
+                label_shape = label_dims;
+                labelled = header.has_label != 0;
+                for (size_t idx = 1; idx < data_shape.size(); idx++) data_row *= data_shape[idx];
+                label_row = labelled ? 1 : 0;
+                for (size_t idx = 1; idx < label_shape.size(); idx++) label_row *= label_shape[idx];
+                rows_per_chunk = (int)header.num_samples;
+                if (rows_per_chunk < 1) throw std::runtime_error("Empty chunk: " + paths[k]);
+            }
+            else if (data_dims != data_shape || label_dims != label_shape)
+                throw std::runtime_error("Chunks with different sample shapes: " + paths[k]);
+            if ((int)header.num_samples > rows_per_chunk || (k + 1 < paths.size() && (int)header.num_samples != rows_per_chunk))
+                throw std::runtime_error("Chunks with different numbers of rows: " + paths[k]);
+            counts.push_back((int)header.num_samples);
+            index_offsets.push_back(header.index_offset);
+            size += (int)header.num_samples;
+        }
+        data_shape[0] = size;
+        if (labelled) label_shape[0] = size;
+        size_t chunk_bytes = rows_per_chunk * (data_row * sizeof(DType) + label_row * sizeof(LType));
+        max_chunks = std::max<size_t>(1, memory_budget / std::max<size_t>(1, chunk_bytes));
+        cached.resize(paths.size());
+        position.resize(paths.size());
+        loading.resize(paths.size());
+    }
+    ChunkedTensorDataset(const ChunkedTensorDataset& dataset) = delete;
+    ChunkedTensorDataset& operator=(const ChunkedTensorDataset& dataset) = delete;
+
+    int len(){ return size; }
+
+    DataLabel<DType, LType> getitem(int index){
+        if (index < 0 || index >= len())
+            throw out_of_range("Index is out of range!");
+        std::shared_ptr<Chunk> chunk = get_chunk(index / rows_per_chunk);
+        int row = index % rows_per_chunk;
+        if (!labelled) return DataLabel<DType, LType>(xt::view(chunk->data, row), LType{});
+        return DataLabel<DType, LType>(xt::view(chunk->data, row), xt::view(chunk->label, row));
+    }
+
+    xt::svector<unsigned long> get_data_shape(){ return data_shape; }
+    xt::svector<unsigned long> get_label_shape(){ return label_shape; }
+
+    /* getitems(indices, out): rows are copied straight from the chunks;
+     *      the cache is only looked up when the chunk changes
+     */
+    void getitems(const xt::xarray<unsigned long>& indices, Batch<DType, LType>& out){
+        int count = (int)indices.size();
+        this->shape_batch(count, out);
+        DType* data = out.getData().data();
+        LType* label = out.getLabel().data();
+        std::shared_ptr<Chunk> chunk;
+        int current = -1;
+        for (int j = 0; j < count; j++) {
+            if (indices(j) >= (unsigned long)size) throw out_of_range("Index is out of range!");
+            int k = (int)(indices(j) / rows_per_chunk);
+            if (k != current) {
+                chunk = get_chunk(k);
+                current = k;
+            }
+            size_t row = indices(j) % rows_per_chunk;
+            memcpy(data + j * data_row, chunk->data.data() + row * data_row, data_row * sizeof(DType));
+            if (labelled) memcpy(label + j * label_row, chunk->label.data() + row * label_row, label_row * sizeof(LType));
+        }
+    }
+
+    int chunk_rows(){ return rows_per_chunk; }
+    int window_chunks(){ return (int)std::min(max_chunks, paths.size()); }
+    int num_chunks(){ return (int)paths.size(); }
+
+    /* cache_hits(), cache_misses(): chunk lookups served from memory / read from disk
+     */
+    long cache_hits(){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        return hits;
+    }
+    long cache_misses(){
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        return misses;
+    }
+
+private:
+    /* get_chunk(k): chunk k, from the cache or read from its file;
+     *      the least recently used chunk is evicted when the cache is full
+     *  + the file is read with cache_mutex released; loading[k] lets the other threads
+     *      that need chunk k wait for this read instead of starting their own
+     */
+    std::shared_ptr<Chunk> get_chunk(int k){
+        std::promise<std::shared_ptr<Chunk>> promise;
+        {
+            std::unique_lock<std::mutex> lock(cache_mutex);
+            if (cached[k]) {
+                hits++;
+                recent.splice(recent.begin(), recent, position[k]);
+                return cached[k];
+            }
+            if (loading[k].valid()) {
+                hits++;
+                std::shared_future<std::shared_ptr<Chunk>> pending = loading[k];
+                lock.unlock();
+                return pending.get();       //rethrows the error of the read, if any
+            }
+            misses++;
+            loading[k] = promise.get_future().share();
+        }
+        std::shared_ptr<Chunk> chunk;
+        try {
+            chunk = load_chunk(k);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            loading[k] = std::shared_future<std::shared_ptr<Chunk>>();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (recent.size() >= max_chunks) {
+            cached[recent.back()].reset();
+            recent.pop_back();
+        }
+        recent.push_front(k);
+        position[k] = recent.begin();
+        cached[k] = chunk;
+        loading[k] = std::shared_future<std::shared_ptr<Chunk>>();
+        promise.set_value(chunk);
+        return chunk;
+    }
+
+    /* load_chunk(k): read the records of chunk k, split them into the data and label rows
+     */
+    std::shared_ptr<Chunk> load_chunk(int k){
+        int rows = counts[k];
+        size_t data_bytes = data_row * sizeof(DType), label_bytes = label_row * sizeof(LType);
+        size_t record = data_bytes + label_bytes;
+        std::ifstream stream(paths[k], std::ios::binary);
+        std::vector<uint64_t> offsets(rows);
+        stream.seekg(index_offsets[k]);
+        if (!stream.read((char*)offsets.data(), rows * sizeof(uint64_t)))
+            throw std::runtime_error("File is truncated: " + paths[k]);
+
+        std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+        xt::svector<size_t> shape(data_shape.begin(), data_shape.end());
+        shape[0] = rows;
+        chunk->data = xt::empty<DType>(shape);
+        if (labelled) {
+            shape.assign(label_shape.begin(), label_shape.end());
+            shape[0] = rows;
+            chunk->label = xt::empty<LType>(shape);
+        }
+        char* data = (char*)chunk->data.data();
+        char* label = (char*)chunk->label.data();
+        bool contiguous = true;
+        for (int row = 1; contiguous && row < rows; row++) contiguous = offsets[row] == offsets[0] + row * record;
+        if (contiguous) {
+            //one read for the whole chunk
+            std::vector<char> buffer(rows * record);
+            stream.seekg(offsets[0]);
+            if (!stream.read(buffer.data(), buffer.size()))
+                throw std::runtime_error("File is truncated: " + paths[k]);
+            for (int row = 0; row < rows; row++) {
+                memcpy(data + row * data_bytes, buffer.data() + row * record, data_bytes);
+                if (labelled) memcpy(label + row * label_bytes, buffer.data() + row * record + data_bytes, label_bytes);
+            }
+            return chunk;
+        }
+        for (int row = 0; row < rows; row++) {
+            stream.seekg(offsets[row]);
+            stream.read(data + row * data_bytes, data_bytes);
+            if (labelled) stream.read(label + row * label_bytes, label_bytes);
+            if (!stream) throw std::runtime_error("File is truncated: " + paths[k]);
+        }
+        return chunk;
+    }
+};
+
+#endif /* CHUNKEDDATASET_H */
@@ -0,0 +1,302 @@
+/*
+ * File:   csvdataset.h
+ */
+
+#ifndef CSVDATASET_H
+#define CSVDATASET_H
+#include "xtensor_lib.h"
+#include "dataset.h"
+#include "../util/MappedFile.h"
+#include "../util/WorkerPool.h"
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <locale.h>
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+using namespace std;
+
+/* CsvColumns: which columns of a CSV row go to the data, which to the label
+ *  + label_columns: indices of the label columns (negative: from the end, -1 = last column)
+ *  + data_columns: indices of the data columns; empty: every column that is not a label
+ *  + role[c] >= 0: position in the data row; role[c] < -1: position -role[c]-2 in the label row;
+ *      role[c] == -1: column not used
+ *  >> throw an exception (std::invalid_argument) if a column is listed twice
+ *      (a label slot would never be written)
+ */
+class CsvColumns{
+public:
+    std::vector<int> role;
+    int num_data, num_label;
+
+    CsvColumns(): num_data(0), num_label(0){}
+    CsvColumns(int num_columns, std::vector<int> data_columns, std::vector<int> label_columns):
+    role(num_columns, -1), num_data(0), num_label(0){
+        for (size_t idx = 0; idx < label_columns.size(); idx++) {
+            int c = position(label_columns[idx], num_columns);
+            if (role[c] != -1) throw std::invalid_argument("A label column is listed twice!");
+            role[c] = -2 - num_label++;
+        }
+        if (data_columns.empty()) {
+            for (int c = 0; c < num_columns; c++)
+                if (role[c] == -1) role[c] = num_data++;
+        }
+        else {
+            for (size_t idx = 0; idx < data_columns.size(); idx++) {
+                int c = position(data_columns[idx], num_columns);
+                if (role[c] < -1) throw std::invalid_argument("A column is both data and label!");
+                if (role[c] != -1) throw std::invalid_argument("A data column is listed twice!");
+                role[c] = num_data++;
+            }
+        }
+    }
+
+    /* count_columns(line, end, delimiter): number of fields in the line [line, end)
+     */
+    static int count_columns(const char* line, const char* end, char delimiter){
+        int count = 1;
+        for (const char* p = line; p < end && *p != '\n'; p++)
+            if (*p == delimiter) count++;
+        return count;
+    }
+
+    /* parse_row(p, end, delimiter, data, label): parse the line starting at p into data, label;
+     *      return the address after the line
+     *  >> throw an exception (std::runtime_error) if the line does not have role.size() fields
+     */
+    template<typename DType, typename LType>
+    const char* parse_row(const char* p, const char* end, char delimiter, DType* data, LType* label){
+        int num_columns = (int)role.size();
+        for (int c = 0; c < num_columns; c++) {
+            const char* field = p;
+            while (p < end && *p != delimiter && *p != '\n') p++;
+            if (c < num_columns - 1 && (p >= end || *p != delimiter))
+                throw std::runtime_error("CSV row with too few fields!");
+            if (role[c] != -1) {
+                double value = parse_number(field, p);
+                if (role[c] >= 0) data[role[c]] = (DType)value;
+                else label[-role[c] - 2] = (LType)value;
+            }
+            if (c < num_columns - 1) p++;
+        }
+        if (p < end && *p != '\n') throw std::runtime_error("CSV row with too many fields!");
+        return p < end ? p + 1 : p;
+    }
+
+    /* parse_number(first, last): the number in [first, last); leading and trailing spaces are skipped
+     *  + "." is the decimal point, whatever the locale of the program (see: c_strtod)
+     *  + the field is copied into a terminated buffer: strtod needs one, and the mapped file
+     *      has none at its end (a local array, or a heap one for a field of 64 characters or more)
+     *  >> throw an exception (std::runtime_error) if the field is empty or not a number
+     */
+    static double parse_number(const char* first, const char* last){
+        while (first < last && (*first == ' ' || *first == '\t')) first++;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+        size_t length = last - first;
+        if (length == 0) throw std::runtime_error("Empty CSV field!");
+        char local[64];
+        std::vector<char> heap;
+        char* buffer = local;
+        if (length >= sizeof(local)) {
+            heap.resize(length + 1);
+            buffer = heap.data();
+        }
+        memcpy(buffer, first, length);
+        buffer[length] = '\0';
+        char* stop;
+        double value = c_strtod(buffer, &stop);
+        if (stop != buffer + length) throw std::runtime_error("Invalid CSV field: " + string(buffer));
+        return value;
+    }
+
+    /* c_strtod(text, stop): strtod in the "C" locale (strtod follows LC_NUMERIC:
+     *      under a locale with a decimal comma, "1.5" would stop at the ".")
+     */
+    static double c_strtod(const char* text, char** stop){
+#ifdef _WIN32
+        static _locale_t c_locale = _create_locale(LC_NUMERIC, "C");
+        return _strtod_l(text, stop, c_locale);
+#else
+        static locale_t c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+        return strtod_l(text, stop, c_locale);
+#endif
+    }
+
+private:
+    static int position(int column, int num_columns){
+        int c = column < 0 ? num_columns + column : column;
+        if (c < 0 || c >= num_columns) throw out_of_range("Column is out of range!");
+        return c;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* CsvDataset: a dataset parsed from a numeric CSV file (one sample per line, no quoted fields)
+ *  + the whole file becomes two compact tensors: data (N, num_data), label (N) or (N, num_label)
+ *      => same behaviour as TensorDataset (DataLoader reads the rows directly, see: RowBuffer)
+ *  + parsing is parallel: the file is mapped (see: MappedFile), cut into chunks at line boundaries;
+ *      a first pass counts the lines of each chunk, the second one parses each chunk
+ *      straight into its rows of the tensors (no temporary per line)
+ *  + num_workers: number of threads (0: one per hardware thread)
+ *  + without label_columns: no label (as TensorDataset with an empty label)
+ * Example: 10 features then the class in the last column, first line = names
+ *      CsvDataset<double, int> ds("train.csv", {-1}, {}, true);
+ */
+template<typename DType, typename LType>
+class CsvDataset: public Dataset<DType, LType>, public RowBuffer<DType, LType>{
+private:
+    xt::xarray<DType> data;
+    xt::xarray<LType> label;
+    xt::svector<unsigned long> data_shape, label_shape;
+
+public:
+    CsvDataset(string path,
+        std::vector<int> label_columns = std::vector<int>(),
+        std::vector<int> data_columns = std::vector<int>(),
+        bool header = false, char delimiter = ',', int num_workers = 0){
+        MappedFile file(path);
+        const char* begin = file.data();
+        const char* end = begin + file.size();
+        if (header) begin = next_line(begin, end);
+        while (begin < end && is_blank_line(begin, end)) begin = next_line(begin, end);
+        CsvColumns columns(CsvColumns::count_columns(begin, end, delimiter), data_columns, label_columns);
+
+        if (num_workers <= 0) num_workers = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+        int num_chunks = num_workers * 4;
+        //chunk k: [cut[k], cut[k+1]), each cut is at the start of a line
+        std::vector<const char*> cut(num_chunks + 1);
+        for (int k = 0; k <= num_chunks; k++) {
+            const char* p = begin + (size_t)(end - begin) * k / num_chunks;
+            cut[k] = (p <= begin || p >= end) ? p : next_line(p - 1, end);
+        }
+        std::vector<size_t> first_row(num_chunks + 1, 0);
+        WorkerPool pool(num_workers);
+        auto count = [&](int k) {
+            size_t rows = 0;
+            for (const char* p = cut[k]; p < cut[k + 1]; p = next_line(p, cut[k + 1]))
+                if (!is_blank_line(p, cut[k + 1])) rows++;
+            first_row[k + 1] = rows;
+        };
+        pool.run(num_chunks, count);
+        for (int k = 0; k < num_chunks; k++) first_row[k + 1] += first_row[k];
+
+        size_t num_rows = first_row[num_chunks];
+        data = xt::empty<DType>({num_rows, (size_t)columns.num_data});
+        if (columns.num_label == 1) label = xt::empty<LType>({num_rows});
+        else if (columns.num_label > 1) label = xt::empty<LType>({num_rows, (size_t)columns.num_label});
+        DType* data_ptr = data.data();
+        LType* label_ptr = label.data();
+        auto parse = [&](int k) {
+            size_t row = first_row[k];
+            for (const char* p = cut[k]; p < cut[k + 1]; row++) {
+                while (p < cut[k + 1] && is_blank_line(p, cut[k + 1])) p = next_line(p, cut[k + 1]);
+                if (p >= cut[k + 1]) break;
+                p = columns.parse_row(p, cut[k + 1], delimiter,
+                    data_ptr + row * columns.num_data, label_ptr + row * columns.num_label);
+            }
+        };
+        pool.run(num_chunks, parse);
+
+        for (size_t idx = 0; idx < data.dimension(); idx++) data_shape.push_back(data.shape()[idx]);
+        if (columns.num_label > 0)
+            for (size_t idx = 0; idx < label.dimension(); idx++) label_shape.push_back(label.shape()[idx]);
+    }
+
+    int len(){ return data_shape[0]; }
+
+    DataLabel<DType, LType> getitem(int index){
+        if (index < 0 || index >= len())
+            throw out_of_range("Index is out of range!");
+        if (label_shape.size() == 0) return DataLabel<DType, LType>(xt::view(data, index), LType{});
+        return DataLabel<DType, LType>(xt::view(data, index), xt::view(label, index));
+    }
+    xt::svector<unsigned long> get_data_shape(){ return data_shape; }
+    xt::svector<unsigned long> get_label_shape(){ return label_shape; }
+
+    xt::xarray<DType>& get_data(){ return data; }
+    xt::xarray<LType>& get_label(){ return label; }
+
+    DType* data_rows(){ return data.data(); }
+    LType* label_rows(){ return label_shape.size() == 0 ? 0 : label.data(); }
+
+    static const char* next_line(const char* p, const char* end){
+        const char* found = (const char*)memchr(p, '\n', end - p);
+        return found == 0 ? end : found + 1;
+    }
+    static bool is_blank_line(const char* p, const char* end){
+        for (; p < end && *p != '\n'; p++)
+            if (*p != ' ' && *p != '\t' && *p != '\r') return false;
+        return true;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* CsvStream: read a CSV file one row at a time, in constant memory
+ *      (files larger than memory, or a single pass; see: CsvDataset for random access)
+ *  + next(data, label): parse the next row into data (num_data) and label
+ *      (num_label values; 0-d if there is one label column, or none);
+ *      return false at the end of the file
+ *  + reset(): back to the first row
+ *  + an IterableDataset: see IterableLoader to make batches
+ */
+template<typename DType, typename LType>
+class CsvStream: public IterableDataset<DType, LType>{
+private:
+    string path;
+    bool header;
+    char delimiter;
+    std::vector<int> data_columns, label_columns;
+    std::ifstream stream;
+    string line;
+    CsvColumns columns;
+    bool started;
+
+public:
+    CsvStream(string path,
+        std::vector<int> label_columns = std::vector<int>(),
+        std::vector<int> data_columns = std::vector<int>(),
+        bool header = false, char delimiter = ','):
+    path(path), header(header), delimiter(delimiter), data_columns(data_columns), label_columns(label_columns){
+        reset();
+    }
+
+    void reset(){
+        stream.close();
+        stream.clear();
+        stream.open(path, std::ios::binary);
+        if (!stream) throw std::runtime_error("Cannot open file: " + path);
+        if (header) std::getline(stream, line);
+        started = false;
+    }
+
+    bool next(xt::xarray<DType>& data, xt::xarray<LType>& label){
+        while (std::getline(stream, line)) {
+            const char* begin = line.data();
+            const char* end = begin + line.size();
+            if (CsvDataset<DType, LType>::is_blank_line(begin, end)) continue;
+            if (!started) {
+                columns = CsvColumns(CsvColumns::count_columns(begin, end, delimiter), data_columns, label_columns);
+                started = true;
+            }
+            if (data.dimension() != 1 || (int)data.size() != columns.num_data)
+                data = xt::empty<DType>({(size_t)columns.num_data});
+            if (columns.num_label <= 1) {
+                if (label.dimension() != 0 || label.storage().size() != 1) label = xt::xarray<LType>(0);
+                *label.data() = 0;
+            }
+            else if (label.dimension() != 1 || (int)label.size() != columns.num_label)
+                label = xt::empty<LType>({(size_t)columns.num_label});
+            columns.parse_row(begin, end, delimiter, data.data(), label.data());
+            return true;
+        }
+        return false;
+    }
+
+    bool has_label(){ return !label_columns.empty(); }
+};
+
+#endif /* CSVDATASET_H */
@@ -13,8 +13,20 @@
 #ifndef DATASET_H
 #define DATASET_H
 #include "xtensor_lib.h"
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
 using namespace std;
 
+/* DataLabel: one sample
+ *  + the tensors given to the constructor are moved in (pass temporaries or std::move to avoid a copy)
+ *  + getData(), getLabel(): a const reference, valid while the DataLabel is alive;
+ *      on a temporary (e.g., ds.getitem(i).getData()) the tensor is moved out instead
+ */
 template<typename DType, typename LType>
 class DataLabel{
 private:
@@ -22,10 +34,12 @@ private:
     xt::xarray<LType> label;
 public:
     DataLabel(xt::xarray<DType> data,  xt::xarray<LType> label):
-    data(data), label(label){
+    data(std::move(data)), label(std::move(label)){
     }
-    xt::xarray<DType> getData() const{ return data; }
-    xt::xarray<LType> getLabel() const{ return label; }
+    const xt::xarray<DType>& getData() const&{ return data; }
+    const xt::xarray<LType>& getLabel() const&{ return label; }
+    xt::xarray<DType> getData() &&{ return std::move(data); }
+    xt::xarray<LType> getLabel() &&{ return std::move(label); }
 };
 
 template<typename DType, typename LType>
@@ -38,11 +52,63 @@ public:
     Batch(xt::xarray<DType> data,  xt::xarray<LType> label):
     data(data), label(label){
     }
+    Batch(const Batch& batch) = default;
+    Batch(Batch&& batch) = default;     //move, not copy, the tensors (e.g., out of the prefetch queue)
+    Batch& operator=(const Batch& batch) = default;
+    Batch& operator=(Batch&& batch) = default;
     virtual ~Batch(){}
     xt::xarray<DType>& getData(){return data; }
     xt::xarray<LType>& getLabel(){return label; }
 };
 
+/* BatchView: a batch whose tensors can point into the memory of a dataset (no copy)
+ *  + getData(), getLabel(): tensors that read and write the memory they point to;
+ *      valid while the source tensors are alive and not resized
+ *  + a tensor with no source (null pointer) is taken from the batch kept in "owned"
+ *      (e.g., rows that are not contiguous in the source, see: DataLoader::get_batch_view)
+ */
+template<typename DType, typename LType>
+class BatchView{
+private:
+    DType* data_ptr;
+    LType* label_ptr;
+    xt::svector<size_t> data_shape, label_shape;
+    Batch<DType, LType> owned;
+public:
+    BatchView(): data_ptr(0), label_ptr(0) {}
+    BatchView(DType* data_ptr, xt::svector<size_t> data_shape,
+              LType* label_ptr, xt::svector<size_t> label_shape,
+              Batch<DType, LType> owned = Batch<DType, LType>()):
+    data_ptr(data_ptr), label_ptr(label_ptr), data_shape(data_shape), label_shape(label_shape), owned(std::move(owned)){
+    }
+    BatchView(Batch<DType, LType> owned): data_ptr(0), label_ptr(0), owned(std::move(owned)){
+    }
+
+    xt::xarray_pointer<DType> getData(){
+        if (data_ptr == 0) return adapt(owned.getData());
+        return xt::adapt(static_cast<DType*>(data_ptr), size_of(data_shape), xt::no_ownership(), data_shape);
+    }
+    xt::xarray_pointer<LType> getLabel(){
+        if (label_ptr == 0) return adapt(owned.getLabel());
+        return xt::adapt(static_cast<LType*>(label_ptr), size_of(label_shape), xt::no_ownership(), label_shape);
+    }
+    /* is_view(): true if the data is not copied
+     */
+    bool is_view(){ return data_ptr != 0; }
+
+private:
+    template<typename T>
+    static xt::xarray_pointer<T> adapt(xt::xarray<T>& tensor){
+        xt::svector<size_t> shape(tensor.shape().begin(), tensor.shape().end());
+        return xt::adapt(tensor.data(), tensor.size(), xt::no_ownership(), shape);
+    }
+    static size_t size_of(xt::svector<size_t>& shape){
+        size_t size = 1;
+        for (size_t idx = 0; idx < shape.size(); idx++) size *= shape[idx];
+        return size;
+    }
+};
+
 
 template<typename DType, typename LType>
 class Dataset{
@@ -55,15 +121,102 @@ public:
     virtual DataLabel<DType, LType> getitem(int index)=0;
     virtual xt::svector<unsigned long> get_data_shape()=0;
     virtual xt::svector<unsigned long> get_label_shape()=0;
-    
+
+    /* getitems(indices, out): the samples indices(0), ..., indices(n-1) as one batch, written into "out"
+     *      (its tensors are reused when they already have the right number of elements)
+     *  + default: one getitem per sample
+     *  + override it when a whole batch can be read at once (e.g., TensorDataset: one copy per row)
+     */
+    virtual void getitems(const xt::xarray<unsigned long>& indices, Batch<DType, LType>& out){
+        int size = (int)indices.size();
+        shape_batch(size, out);
+        xt::xarray<DType>& data = out.getData();
+        xt::xarray<LType>& label = out.getLabel();
+        bool labelled = get_label_shape().size() != 0;
+        for (int j = 0; j < size; j++) {
+            DataLabel<DType, LType> item = getitem(indices(j));
+            xt::view(data, j) = item.getData();
+            if (labelled) xt::view(label, j) = item.getLabel();
+        }
+    }
+
+protected:
+    /* shape_batch(int size, out): resize the tensors of "out" for "size" samples;
+     *      without label (empty label shape): the label is the 0-d tensor 0
+     */
+    void shape_batch(int size, Batch<DType, LType>& out){
+        auto datas = get_data_shape();
+        auto labels = get_label_shape();
+        datas[0] = size;
+        out.getData().resize(datas);
+        xt::xarray<LType>& label = out.getLabel();
+        if (labels.size() == 0) {
+            if (label.dimension() != 0 || label.storage().size() != 1) label = xt::xarray<LType>(0);
+            *label.data() = 0;
+        }
+        else {
+            labels[0] = size;
+            label.resize(labels);
+        }
+    }
+};
+
+/* IterableDataset: a stream of samples, read in order (e.g., records larger than memory)
+ *  + next(data, label): write the next sample into data, label (their storage is reused);
+ *      return false at the end of the stream
+ *      label: 0-d tensor if the sample has a single label value
+ *  + reset(): go back to the first sample (a new pass)
+ *  + has_label(): false => batches get the 0-d label 0 (as TensorDataset with an empty label)
+ */
+template<typename DType, typename LType>
+class IterableDataset{
+public:
+    IterableDataset(){};
+    virtual ~IterableDataset(){};
+
+    virtual bool next(xt::xarray<DType>& data, xt::xarray<LType>& label)=0;
+    virtual void reset()=0;
+    virtual bool has_label()=0;
+};
+
+/* RowBuffer: a dataset whose samples are the rows of row-major buffers in memory
+ *      sample i: data_rows() + i * (size of a data row), same for the label
+ *  DataLoader reads these rows directly, without getitem (see: DataLoader::gather)
+ */
+template<typename DType, typename LType>
+class RowBuffer{
+public:
+    virtual ~RowBuffer(){}
+    virtual DType* data_rows()=0;
+    virtual LType* label_rows()=0;      //0: no label
+};
+
+/* ChunkedRows: a dataset that reads its samples by chunks of chunk_rows() consecutive samples
+ *      (sample i is in chunk i / chunk_rows()), and keeps at most window_chunks() chunks in memory
+ *  DataLoader shuffles such a dataset chunk by chunk (see: ChunkSampler)
+ */
+class ChunkedRows{
+public:
+    virtual ~ChunkedRows(){}
+    virtual int chunk_rows()=0;
+    virtual int window_chunks()=0;
 };
 
 //////////////////////////////////////////////////////////////////////
+/* TensorDataset: the samples are the rows (dimension 0) of two tensors held in memory
+ *  + TensorDataset(data, label): the tensors are moved in;
+ *      pass std::move(X) (or a temporary) to avoid copying them
+ *  + TensorDataset(shared data, shared label): no copy, the tensors are shared with the caller
+ *      (e.g., several datasets over the same tensors); a null label: no label
+ *  + label with dimension 0: no label
+ */
 template<typename DType, typename LType>
-class TensorDataset: public Dataset<DType, LType>{
+class TensorDataset: public Dataset<DType, LType>, public RowBuffer<DType, LType>{
 private:
-    xt::xarray<DType> data;
-    xt::xarray<LType> label;
+    std::shared_ptr<xt::xarray<DType>> data_owner;
+    std::shared_ptr<xt::xarray<LType>> label_owner;
+    xt::xarray<DType>& data;
+    xt::xarray<LType>& label;
     xt::svector<unsigned long> data_shape, label_shape;
 public:
     /* TensorDataset: 
@@ -71,17 +224,16 @@ public:
      * 1. data, label;
      * 2. data_shape, label_shape
     */
-    TensorDataset(xt::xarray<DType> data, xt::xarray<LType> label) : data(data), label(label)  {
-        /* TODO: your code is here for the initialization
-         */
-        for (int i = 0; i < data.dimension(); i++) {
-            int num = data.shape().at(i);
-            data_shape.push_back(num);
-        }
-        for (int i = 0; i < label.dimension(); i++) {
-            int num = label.shape().at(i);
-            label_shape.push_back(num);
-        }
+    TensorDataset(xt::xarray<DType> data, xt::xarray<LType> label):
+    data_owner(std::make_shared<xt::xarray<DType>>(std::move(data))),
+    label_owner(std::make_shared<xt::xarray<LType>>(std::move(label))),
+    data(*data_owner), label(*label_owner){
+        set_shapes();
+    }
+    TensorDataset(std::shared_ptr<xt::xarray<DType>> data, std::shared_ptr<xt::xarray<LType>> label):
+    data_owner(data), label_owner(label ? label : std::make_shared<xt::xarray<LType>>()),
+    data(*check(data_owner)), label(*label_owner){
+        set_shapes();
     }
     /* len():
      *  return the size of dimension 0
@@ -98,20 +250,14 @@ public:
     DataLabel<DType, LType> getitem(int index){
         /* TODO: your code is here
          */
-        if (data.dimension() != 0 && label.dimension() == 0) {
-            xt::xarray<DType> datatemp = xt::view(data, index);
-            DataLabel<DType, LType> result = DataLabel<DType, LType>(datatemp, LType{});
-            return result;
-        }
-        else {
-            if (data_shape[0] == label_shape[0]) {
-                xt::xarray<DType> datatemp = xt::view(data, index);
-                xt::xarray<DType> labeltemp = xt::view(label, index);
-                DataLabel<DType, LType> result = DataLabel<DType, LType>(datatemp, labeltemp);
-                return result;
-            }
-            throw;
-        }
+        if (index < 0 || index >= len())
+            throw out_of_range("Index is out of range!");
+        //the row is copied once, straight into the DataLabel
+        if (label.dimension() == 0)
+            return DataLabel<DType, LType>(xt::view(data, index), LType{});
+        if (data_shape[0] != label_shape[0])
+            throw std::runtime_error("Data and label have different numbers of samples!");
+        return DataLabel<DType, LType>(xt::view(data, index), xt::view(label, index));
     }
     
     xt::svector<unsigned long> get_data_shape(){
@@ -124,9 +270,189 @@ public:
          */
         return label_shape;
     }
+
+    /* get_data, get_label: the whole tensors (row-major, dimension-0 = samples)
+     *      used by DataLoader to copy rows without going through getitem
+     */
+    xt::xarray<DType>& get_data(){ return data; }
+    xt::xarray<LType>& get_label(){ return label; }
+
+    DType* data_rows(){ return data.data(); }
+    LType* label_rows(){ return label.dimension() == 0 ? 0 : label.data(); }
+
+    std::shared_ptr<xt::xarray<DType>> share_data(){ return data_owner; }
+    std::shared_ptr<xt::xarray<LType>> share_label(){ return label_owner; }
+
+    /* getitems(indices, out): rows are contiguous in data and label => one copy per row,
+     *      no DataLabel nor temporary tensor per sample
+     */
+    void getitems(const xt::xarray<unsigned long>& indices, Batch<DType, LType>& out){
+        bool labelled = label_shape.size() != 0;
+        if (data_shape.size() == 0 || (labelled && label_shape[0] != data_shape[0])) {
+            Dataset<DType, LType>::getitems(indices, out);
+            return;
+        }
+        int size = (int)indices.size();
+        this->shape_batch(size, out);
+        size_t data_row = data.size() / data_shape[0];
+        size_t label_row = labelled ? label.size() / label_shape[0] : 0;
+        DType* data_out = out.getData().data();
+        LType* label_out = out.getLabel().data();
+        for (int j = 0; j < size; j++) {
+            size_t index = indices(j);
+            if (index >= data_shape[0]) throw out_of_range("Index is out of range!");
+            std::copy(data.data() + index * data_row, data.data() + (index + 1) * data_row, data_out + j * data_row);
+            if (labelled)
+                std::copy(label.data() + index * label_row, label.data() + (index + 1) * label_row, label_out + j * label_row);
+        }
+    }
+
+private:
+    void set_shapes(){
+        for (size_t i = 0; i < data.dimension(); i++) data_shape.push_back(data.shape()[i]);
+        for (size_t i = 0; i < label.dimension(); i++) label_shape.push_back(label.shape()[i]);
+    }
+    template<typename T>
+    static std::shared_ptr<T>& check(std::shared_ptr<T>& tensor){
+        if (!tensor) throw std::invalid_argument("TensorDataset needs a data tensor!");
+        return tensor;
+    }
 };
 
+//////////////////////////////////////////////////////////////////////
+/* SubsetDataset: the samples indices(0), indices(1), ... of another dataset (no copy)
+ *  + sample i = dataset->getitem(indices(i)); getitems is forwarded with the mapped indices
+ *  + the dataset is not owned: it must outlive the subset
+ *  >> throw an exception (std::out_of_range) if an index is >= dataset->len()
+ */
+template<typename DType, typename LType>
+class SubsetDataset: public Dataset<DType, LType>{
+private:
+    Dataset<DType, LType>* dataset;
+    xt::xarray<unsigned long> indices;
+    xt::xarray<unsigned long> mapped;       //parent indices of the last getitems
+public:
+    SubsetDataset(Dataset<DType, LType>* dataset, xt::xarray<unsigned long> indices):
+    dataset(dataset), indices(std::move(indices)){
+        unsigned long size = dataset->len();
+        for (size_t idx = 0; idx < this->indices.size(); idx++)
+            if (this->indices(idx) >= size) throw out_of_range("Index is out of range!");
+    }
+    int len(){ return (int)indices.size(); }
+    DataLabel<DType, LType> getitem(int index){
+        if (index < 0 || index >= len())
+            throw out_of_range("Index is out of range!");
+        return dataset->getitem(indices(index));
+    }
+    xt::svector<unsigned long> get_data_shape(){
+        xt::svector<unsigned long> shape = dataset->get_data_shape();
+        shape[0] = indices.size();
+        return shape;
+    }
+    xt::svector<unsigned long> get_label_shape(){
+        xt::svector<unsigned long> shape = dataset->get_label_shape();
+        if (shape.size() != 0) shape[0] = indices.size();
+        return shape;
+    }
+    void getitems(const xt::xarray<unsigned long>& batch, Batch<DType, LType>& out){
+        mapped.resize({batch.size()});
+        for (size_t idx = 0; idx < batch.size(); idx++) {
+            if (batch(idx) >= indices.size()) throw out_of_range("Index is out of range!");
+            mapped(idx) = indices(batch(idx));
+        }
+        dataset->getitems(mapped, out);
+    }
+    const xt::xarray<unsigned long>& get_indices(){ return indices; }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* ConcatDataset: the samples of several datasets, one after the other (no copy)
+ *  + sample i is found by a binary search over the cumulative lengths: O(log(number of datasets))
+ *  + the datasets are not owned: they must outlive this one
+ *  >> throw an exception (std::invalid_argument) if the samples of the datasets have different shapes
+ */
+template<typename DType, typename LType>
+class ConcatDataset: public Dataset<DType, LType>{
+private:
+    std::vector<Dataset<DType, LType>*> datasets;
+    std::vector<int> ends;      //ends[k]: number of samples in datasets[0..k]
+public:
+    ConcatDataset(std::vector<Dataset<DType, LType>*> datasets): datasets(datasets){
+        if (datasets.empty()) throw std::invalid_argument("ConcatDataset needs at least one dataset!");
+        int total = 0;
+        for (size_t k = 0; k < datasets.size(); k++) {
+            if (!same_item_shape(datasets[k]->get_data_shape(), datasets[0]->get_data_shape()) ||
+                !same_item_shape(datasets[k]->get_label_shape(), datasets[0]->get_label_shape()))
+                throw std::invalid_argument("Datasets with different sample shapes!");
+            total += datasets[k]->len();
+            ends.push_back(total);
+        }
+    }
+    int len(){ return ends.back(); }
+    DataLabel<DType, LType> getitem(int index){
+        if (index < 0 || index >= len())
+            throw out_of_range("Index is out of range!");
+        int k = (int)(std::upper_bound(ends.begin(), ends.end(), index) - ends.begin());
+        return datasets[k]->getitem(k == 0 ? index : index - ends[k - 1]);
+    }
+    xt::svector<unsigned long> get_data_shape(){
+        xt::svector<unsigned long> shape = datasets[0]->get_data_shape();
+        shape[0] = len();
+        return shape;
+    }
+    xt::svector<unsigned long> get_label_shape(){
+        xt::svector<unsigned long> shape = datasets[0]->get_label_shape();
+        if (shape.size() != 0) shape[0] = len();
+        return shape;
+    }
 
+private:
+    static bool same_item_shape(const xt::svector<unsigned long>& a, const xt::svector<unsigned long>& b){
+        return a.size() == b.size() && std::equal(a.begin() + (a.size() > 0), a.end(), b.begin() + (b.size() > 0));
+    }
+};
+
+/* random_split(dataset, fractions, seed): split the samples of dataset at random
+ *      into fractions.size() disjoint subsets (see: SubsetDataset, no copy of the data)
+ *  + subset k has floor(fractions[k] * len) samples; the remaining ones go to the first subsets,
+ *      one each, so that every sample is in exactly one subset
+ *  + seed >= 0: the same split on every run; seed < 0: a different split each time
+ *  >> throw an exception (std::invalid_argument) if the fractions are negative or do not sum to 1
+ * Example: 80% train, 20% validation
+ *      auto parts = random_split(&ds, {0.8, 0.2}, 42);
+ *      DataLoader<double, int> train(&parts[0], 32), valid(&parts[1], 32, false);
+ */
+template<typename DType, typename LType>
+std::vector<SubsetDataset<DType, LType>> random_split(Dataset<DType, LType>* dataset,
+        std::vector<double> fractions, int seed = -1){
+    double total = 0;
+    for (size_t k = 0; k < fractions.size(); k++) {
+        if (!(fractions[k] >= 0)) throw std::invalid_argument("Fractions must be >= 0!");
+        total += fractions[k];
+    }
+    if (fractions.empty() || std::abs(total - 1.0) > 1e-6)
+        throw std::invalid_argument("Fractions must sum to 1!");
+
+    int size = dataset->len();
+    std::vector<int> counts(fractions.size());
+    int assigned = 0;
+    for (size_t k = 0; k < fractions.size(); k++) {
+        counts[k] = (int)(fractions[k] * size);
+        assigned += counts[k];
+    }
+    for (int k = 0; assigned < size; k = (k + 1) % (int)counts.size(), assigned++) counts[k]++;
+
+    xt::random::default_engine_type engine(seed >= 0 ? (unsigned)seed : std::random_device()());
+    xt::xarray<unsigned long> order = xt::arange<unsigned long>(size);
+    xt::random::shuffle(order, engine);
+    std::vector<SubsetDataset<DType, LType>> subsets;
+    int start = 0;
+    for (size_t k = 0; k < counts.size(); k++) {
+        subsets.push_back(SubsetDataset<DType, LType>(dataset, xt::view(order, xt::range(start, start + counts[k]))));
+        start += counts[k];
+    }
+    return subsets;
+}
 
 #endif /* DATASET_H */
 
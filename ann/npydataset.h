@@ -0,0 +1,144 @@
+/*
+ * File:   npydataset.h
+ */
+
+#ifndef NPYDATASET_H
+#define NPYDATASET_H
+#include "xtensor_lib.h"
+#include "xtensor/xnpy.hpp"
+#include "dataset.h"
+#include "../util/MappedFile.h"
+#include <fstream>
+#include <stdexcept>
+using namespace std;
+
+/* NpyDataset: a dataset read from .npy files (numpy.save) without loading them
+ *  + the files are mapped into memory (see: MappedFile): opening a multi-GB file is immediate,
+ *      and the processes that open the same file share its pages
+ *  + sample i = row i (dimension 0) of the data file, and of the label file if any
+ *  + getitem copies one row; DataLoader reads the rows directly (RowBuffer),
+ *      or points into the mapping (DataLoader::get_batch_view)
+ *  >> throw an exception (std::runtime_error) if a file is not a C-ordered .npy of DType/LType,
+ *      (std::invalid_argument) if the data is a 0-d array
+ */
+template<typename DType, typename LType>
+class NpyDataset: public Dataset<DType, LType>, public RowBuffer<DType, LType>{
+private:
+    MappedFile* data_file;
+    MappedFile* label_file;
+    DType* data_ptr;
+    LType* label_ptr;
+    xt::svector<unsigned long> data_shape, label_shape;
+    size_t data_row, label_row;     //number of elements in one sample
+
+public:
+    /* NpyDataset(data_path, label_path): label_path == "": no label (as TensorDataset with an empty label)
+     */
+    NpyDataset(string data_path, string label_path = ""): data_file(0), label_file(0), data_ptr(0), label_ptr(0){
+        data_file = new MappedFile(data_path);
+        try {
+            data_ptr = (DType*)map_npy<DType>(data_path, data_file, data_shape, data_row);
+            if (data_shape.size() == 0)
+                throw std::invalid_argument("A 0-d array has no samples: " + data_path);
+            if (label_path != "") {
+                label_file = new MappedFile(label_path);
+                label_ptr = (LType*)map_npy<LType>(label_path, label_file, label_shape, label_row);
+                if (label_shape.size() == 0 || data_shape.size() == 0 || label_shape[0] != data_shape[0])
+                    throw std::runtime_error("Data and label have different numbers of samples!");
+            }
+        }
+        catch (...) {
+            delete data_file;
+            delete label_file;
+            throw;
+        }
+    }
+    ~NpyDataset(){
+        delete data_file;
+        delete label_file;
+    }
+    NpyDataset(const NpyDataset& dataset) = delete;
+    NpyDataset& operator=(const NpyDataset& dataset) = delete;
+
+    int len(){
+        return data_shape[0];
+    }
+
+    DataLabel<DType, LType> getitem(int index){
+        if (index < 0 || index >= len())
+            throw out_of_range("Index is out of range!");
+        xt::xarray<DType> data = row(data_ptr + index * data_row, data_shape);
+        if (label_ptr == 0) return DataLabel<DType, LType>(std::move(data), LType{});
+        return DataLabel<DType, LType>(std::move(data), row(label_ptr + index * label_row, label_shape));
+    }
+
+    xt::svector<unsigned long> get_data_shape(){ return data_shape; }
+    xt::svector<unsigned long> get_label_shape(){ return label_shape; }
+
+    /* get_data, get_label: the whole arrays, as tensors pointing into the mapping (no copy)
+     */
+    xt::xarray_pointer<DType> get_data(){ return whole(data_ptr, data_shape); }
+    xt::xarray_pointer<LType> get_label(){ return whole(label_ptr, label_shape); }
+
+    DType* data_rows(){ return data_ptr; }
+    LType* label_rows(){ return label_ptr; }
+
+private:
+    /* map_npy(path, file, shape, row): check the header of the .npy file,
+     *      return the address of its first element in the mapping
+     */
+    template<typename T>
+    static char* map_npy(string& path, MappedFile* file, xt::svector<unsigned long>& shape, size_t& row){
+        std::ifstream stream(path, std::ios::binary);
+        unsigned char v_major, v_minor;
+        xt::detail::read_magic(stream, &v_major, &v_minor);
+        std::string header;
+        if (v_major == 1) header = xt::detail::read_header_1_0(stream);
+        else if (v_major == 2 || v_major == 3) header = xt::detail::read_header_2_0(stream);
+        else throw std::runtime_error("Unsupported .npy version: " + path);
+        std::string descr;
+        bool fortran_order;
+        std::vector<std::size_t> dims;
+        xt::detail::parse_header(header, descr, &fortran_order, dims);
+        size_t offset = (size_t)stream.tellg();
+
+        if (descr != xt::detail::build_typestring<T>())
+            throw std::runtime_error("Type " + descr + " in " + path + ", expected " + xt::detail::build_typestring<T>());
+        if (fortran_order)
+            throw std::runtime_error("Fortran order is not supported: " + path);
+        size_t count = 1;
+        shape.clear();
+        for (size_t idx = 0; idx < dims.size(); idx++) {
+            shape.push_back(dims[idx]);
+            count *= dims[idx];
+        }
+        row = dims.size() == 0 || dims[0] == 0 ? count : count / dims[0];
+        if (file->size() < offset + count * sizeof(T))
+            throw std::runtime_error("File is truncated: " + path);
+        if (offset % alignof(T) != 0)
+            throw std::runtime_error("Misaligned data in: " + path);
+        return file->data() + offset;
+    }
+
+    /* row(ptr, shape): copy of one sample (shape without dimension 0)
+     */
+    template<typename T>
+    static xt::xarray<T> row(T* ptr, xt::svector<unsigned long>& shape){
+        xt::svector<size_t> item_shape;
+        size_t count = 1;
+        for (size_t idx = 1; idx < shape.size(); idx++) {
+            item_shape.push_back(shape[idx]);
+            count *= shape[idx];
+        }
+        return xt::adapt(static_cast<T*>(ptr), count, xt::no_ownership(), item_shape);
+    }
+    template<typename T>
+    static xt::xarray_pointer<T> whole(T* ptr, xt::svector<unsigned long>& shape){
+        xt::svector<size_t> full_shape(shape.begin(), shape.end());
+        size_t count = 1;
+        for (size_t idx = 0; idx < shape.size(); idx++) count *= shape[idx];
+        return xt::adapt(static_cast<T*>(ptr), ptr == 0 ? 0 : count, xt::no_ownership(), full_shape);
+    }
+};
+
+#endif /* NPYDATASET_H */
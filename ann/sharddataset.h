@@ -0,0 +1,279 @@
+/*
+ * File:   sharddataset.h
+ */
+
+#ifndef SHARDDATASET_H
+#define SHARDDATASET_H
+#include "xtensor_lib.h"
+#include "xtensor/xnpy.hpp"
+#include "dataset.h"
+#include "../util/MappedFile.h"
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+using namespace std;
+
+/* Shard file: a dataset dumped as fixed-size binary records (host byte order)
+ *  + header (ShardHeader), then the dimensions of one sample:
+ *      data_ndim values for the data, label_ndim values for the label (uint64 each);
+ *      padded to a multiple of 64 bytes
+ *  + records: sample i = its data row then its label row (no label: data only)
+ *  + index (footer, at index_offset): num_samples uint64, the file offset of each record
+ *  + types are numpy type strings (e.g., "<f8", see: xt::detail::build_typestring)
+ */
+struct ShardHeader{
+    char magic[8];              //"DSASHARD"
+    uint32_t version;
+    uint32_t has_label;
+    char data_type[8];
+    char label_type[8];
+    uint32_t data_ndim;         //dimensions of one sample (without dimension 0)
+    uint32_t label_ndim;
+    uint64_t num_samples;
+    uint64_t index_offset;
+};
+
+static const char SHARD_MAGIC[8] = {'D', 'S', 'A', 'S', 'H', 'A', 'R', 'D'};
+
+/* read_shard_header(stream, path, header, data_dims, label_dims): read and check the header of a shard
+ *      data_dims, label_dims: shapes of the data and label, dimension 0 left at 0 (label_dims empty: no label)
+ *  >> throw an exception (std::runtime_error) if "path" is not a shard of DType/LType
+ */
+template<typename DType, typename LType>
+void read_shard_header(std::istream& stream, const string& path, ShardHeader& header,
+        xt::svector<unsigned long>& data_dims, xt::svector<unsigned long>& label_dims){
+    if (!stream.read((char*)&header, sizeof(header)) || memcmp(header.magic, SHARD_MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error("Not a shard file: " + path);
+    if (header.version != 1)
+        throw std::runtime_error("Unsupported shard version: " + path);
+    if (string(header.data_type, strnlen(header.data_type, 8)) != xt::detail::build_typestring<DType>() ||
+        (header.has_label && string(header.label_type, strnlen(header.label_type, 8)) != xt::detail::build_typestring<LType>()))
+        throw std::runtime_error("Wrong data or label type in: " + path);
+    size_t ndim = header.data_ndim + header.label_ndim;
+    std::vector<uint64_t> dims(ndim);
+    if (!stream.read((char*)dims.data(), ndim * sizeof(uint64_t)))
+        throw std::runtime_error("File is truncated: " + path);
+    data_dims.clear();
+    label_dims.clear();
+    data_dims.push_back(0);
+    for (size_t idx = 0; idx < header.data_ndim; idx++) data_dims.push_back(dims[idx]);
+    if (header.has_label) {
+        label_dims.push_back(0);
+        for (size_t idx = header.data_ndim; idx < ndim; idx++) label_dims.push_back(dims[idx]);
+    }
+}
+
+/* shard_path(prefix, k): prefix-0000k.shard
+ */
+inline string shard_path(const string& prefix, int k){
+    string number = to_string(k);
+    return prefix + "-" + string(5 - std::min<size_t>(5, number.size()), '0') + number + ".shard";
+}
+
+/* write_shard(dataset, path, first, count): write the samples first, ..., first+count-1
+ *      of dataset (count < 0: up to the end) into the shard file "path"
+ *  + samples are read batch_size at a time (see: Dataset::getitems)
+ *  >> throw an exception (std::runtime_error) if the file cannot be written
+ */
+template<typename DType, typename LType>
+void write_shard(Dataset<DType, LType>* dataset, string path, int first = 0, int count = -1, int batch_size = 256){
+    int size = dataset->len();
+    if (count < 0) count = size - first;
+    if (first < 0 || count < 0 || first + count > size) throw out_of_range("Samples are out of range!");
+
+    xt::svector<unsigned long> data_shape = dataset->get_data_shape();
+    xt::svector<unsigned long> label_shape = dataset->get_label_shape();
+    bool labelled = label_shape.size() != 0;
+    size_t data_row = 1, label_row = labelled ? 1 : 0;
+    for (size_t idx = 1; idx < data_shape.size(); idx++) data_row *= data_shape[idx];
+    for (size_t idx = 1; idx < label_shape.size(); idx++) label_row *= label_shape[idx];
+    size_t record = data_row * sizeof(DType) + label_row * sizeof(LType);
+
+    ShardHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SHARD_MAGIC, sizeof(header.magic));
+    header.version = 1;
+    header.has_label = labelled;
+    strncpy(header.data_type, xt::detail::build_typestring<DType>().c_str(), sizeof(header.data_type));
+    strncpy(header.label_type, xt::detail::build_typestring<LType>().c_str(), sizeof(header.label_type));
+    header.data_ndim = (uint32_t)data_shape.size() - 1;
+    header.label_ndim = labelled ? (uint32_t)label_shape.size() - 1 : 0;
+    header.num_samples = count;
+    std::vector<uint64_t> dims;
+    for (size_t idx = 1; idx < data_shape.size(); idx++) dims.push_back(data_shape[idx]);
+    for (size_t idx = 1; idx < label_shape.size(); idx++) dims.push_back(label_shape[idx]);
+    size_t records_offset = (sizeof(header) + dims.size() * sizeof(uint64_t) + 63) / 64 * 64;
+    header.index_offset = (records_offset + count * record + 7) / 8 * 8;
+
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream) throw std::runtime_error("Cannot write file: " + path);
+    stream.write((const char*)&header, sizeof(header));
+    stream.write((const char*)dims.data(), dims.size() * sizeof(uint64_t));
+    std::vector<char> padding(records_offset - sizeof(header) - dims.size() * sizeof(uint64_t), 0);
+    stream.write(padding.data(), padding.size());
+
+    Batch<DType, LType> batch;
+    xt::xarray<unsigned long> indices;
+    for (int start = 0; start < count; start += batch_size) {
+        int num = std::min(batch_size, count - start);
+        indices = xt::arange<unsigned long>(first + start, first + start + num);
+        dataset->getitems(indices, batch);
+        const DType* data = batch.getData().data();
+        const LType* label = batch.getLabel().data();
+        for (int j = 0; j < num; j++) {
+            stream.write((const char*)(data + j * data_row), data_row * sizeof(DType));
+            if (labelled) stream.write((const char*)(label + j * label_row), label_row * sizeof(LType));
+        }
+    }
+    padding.assign(header.index_offset - records_offset - count * record, 0);
+    stream.write(padding.data(), padding.size());
+    std::vector<uint64_t> offsets(count);
+    for (int idx = 0; idx < count; idx++) offsets[idx] = records_offset + idx * record;
+    stream.write((const char*)offsets.data(), offsets.size() * sizeof(uint64_t));
+    if (!stream) throw std::runtime_error("Cannot write file: " + path);
+}
+
+/* write_shards(dataset, prefix, num_shards): cut dataset into num_shards shard files
+ *      of (almost) the same number of samples: prefix-00000.shard, prefix-00001.shard, ...
+ *      return their paths (see: ShardDataset)
+ */
+template<typename DType, typename LType>
+std::vector<string> write_shards(Dataset<DType, LType>* dataset, string prefix, int num_shards){
+    if (num_shards < 1) throw std::invalid_argument("num_shards must be >= 1!");
+    std::vector<string> paths;
+    int size = dataset->len();
+    for (int k = 0; k < num_shards; k++) {
+        string path = shard_path(prefix, k);
+        int first = (int)((long long)size * k / num_shards);
+        int last = (int)((long long)size * (k + 1) / num_shards);
+        write_shard(dataset, path, first, last - first);
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+//////////////////////////////////////////////////////////////////////
+/* ShardDataset: the samples of one or more shard files (see: write_shard), as one dataset
+ *  + the files are mapped into memory (see: MappedFile): opening reads the headers and checks the indexes,
+ *      no record is read
+ *  + getitem(i): the shard is found by a binary search over the cumulative lengths,
+ *      the record by the index of the shard: O(1) in the number of samples
+ *  >> throw an exception (std::runtime_error) if a file is not a shard of DType/LType,
+ *      or if the shards have different sample shapes
+ */
+template<typename DType, typename LType>
+class ShardDataset: public Dataset<DType, LType>{
+private:
+    std::vector<MappedFile*> files;
+    std::vector<const uint64_t*> index;     //index[k]: record offsets of shard k
+    std::vector<int> ends;                  //ends[k]: number of samples in shards 0..k
+    xt::svector<unsigned long> data_shape, label_shape;
+    size_t data_row, label_row;             //number of elements in one sample
+    bool labelled;
+
+public:
+    ShardDataset(string path): ShardDataset(std::vector<string>(1, path)){}
+    ShardDataset(std::vector<string> paths): data_row(1), label_row(0), labelled(false){
+        if (paths.empty()) throw std::invalid_argument("ShardDataset needs at least one file!");
+        try {
+            int total = 0;
+            for (size_t k = 0; k < paths.size(); k++) {
+                files.push_back(new MappedFile(paths[k]));
+                total += open_shard(paths[k], files.back(), k == 0);
+                ends.push_back(total);
+            }
+        }
+        catch (...) {
+            for (size_t k = 0; k < files.size(); k++) delete files[k];
+            throw;
+        }
+        data_shape[0] = ends.back();
+        if (labelled) label_shape[0] = ends.back();
+    }
+    ~ShardDataset(){
+        for (size_t k = 0; k < files.size(); k++) delete files[k];
+    }
+    ShardDataset(const ShardDataset& dataset) = delete;
+    ShardDataset& operator=(const ShardDataset& dataset) = delete;
+
+    int len(){ return ends.back(); }
+
+    DataLabel<DType, LType> getitem(int index){
+        const char* record = find(index);
+        xt::xarray<DType> data = xt::empty<DType>(item_shape(data_shape));
+        memcpy(data.data(), record, data_row * sizeof(DType));
+        if (!labelled) return DataLabel<DType, LType>(std::move(data), LType{});
+        xt::xarray<LType> label = xt::empty<LType>(item_shape(label_shape));
+        memcpy(label.data(), record + data_row * sizeof(DType), label_row * sizeof(LType));
+        return DataLabel<DType, LType>(std::move(data), std::move(label));
+    }
+
+    xt::svector<unsigned long> get_data_shape(){ return data_shape; }
+    xt::svector<unsigned long> get_label_shape(){ return label_shape; }
+
+    /* getitems(indices, out): each record is copied straight into its row of the batch
+     */
+    void getitems(const xt::xarray<unsigned long>& indices, Batch<DType, LType>& out){
+        int size = (int)indices.size();
+        this->shape_batch(size, out);
+        DType* data = out.getData().data();
+        LType* label = out.getLabel().data();
+        for (int j = 0; j < size; j++) {
+            const char* record = find(indices(j) >= (unsigned long)len() ? -1 : (int)indices(j));
+            memcpy(data + j * data_row, record, data_row * sizeof(DType));
+            if (labelled) memcpy(label + j * label_row, record + data_row * sizeof(DType), label_row * sizeof(LType));
+        }
+    }
+
+    int num_shards(){ return (int)files.size(); }
+
+private:
+    /* open_shard(path, file, first): check the header of the shard, keep its index;
+     *      return its number of samples
+     */
+    int open_shard(string& path, MappedFile* file, bool first){
+        std::ifstream stream(path, std::ios::binary);
+        ShardHeader header;
+        xt::svector<unsigned long> data_dims, label_dims;
+        read_shard_header<DType, LType>(stream, path, header, data_dims, label_dims);
+        if (first) {
+            data_shape = data_dims;
+            label_shape = label_dims;
+            labelled = header.has_label != 0;
+            for (size_t idx = 1; idx < data_shape.size(); idx++) data_row *= data_shape[idx];
+            label_row = labelled ? 1 : 0;
+            for (size_t idx = 1; idx < label_shape.size(); idx++) label_row *= label_shape[idx];
+        }
+        else if (data_dims != data_shape || label_dims != label_shape)      //dimension 0 is still 0 in both
+            throw std::runtime_error("Shards with different sample shapes: " + path);
+
+        size_t record = data_row * sizeof(DType) + label_row * sizeof(LType);
+        size_t count = header.num_samples;
+        if (header.index_offset % 8 != 0 || file->size() < header.index_offset + count * sizeof(uint64_t))
+            throw std::runtime_error("File is truncated: " + path);
+        const uint64_t* offsets = (const uint64_t*)(file->data() + header.index_offset);
+        for (size_t idx = 0; idx < count; idx++)
+            if (offsets[idx] + record > header.index_offset)
+                throw std::runtime_error("Invalid record offset in: " + path);
+        index.push_back(offsets);
+        return (int)count;
+    }
+
+    /* find(index): address of the record of sample index
+     */
+    const char* find(int index){
+        if (index < 0 || index >= len())
+            throw out_of_range("Index is out of range!");
+        int k = (int)(std::upper_bound(ends.begin(), ends.end(), index) - ends.begin());
+        return files[k]->data() + this->index[k][k == 0 ? index : index - ends[k - 1]];
+    }
+
+    static xt::svector<size_t> item_shape(xt::svector<unsigned long>& shape){
+        return xt::svector<size_t>(shape.begin() + 1, shape.end());
+    }
+};
+
+#endif /* SHARDDATASET_H */
@@ -25,6 +25,7 @@ using namespace std;
 #include "xtensor/xindex_view.hpp"
 #include "xtensor/xsort.hpp"
 #include "xtensor/xarray.hpp"
+#include "xtensor/xadapt.hpp"
 #include <ctime>
 
 typedef unsigned long ulong;
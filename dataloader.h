@@ -14,6 +14,19 @@
 #define DATALOADER_H
 #include "ann/xtensor_lib.h"
 #include "ann/dataset.h"
+#include "util/WorkerPool.h"
+#include "sampler.h"
+#include "transform.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <exception>
+#include <cstring>
+#include <type_traits>
+#include <random>
+#include <deque>
+#include <stdexcept>
 
 using namespace std;
 
@@ -21,88 +34,526 @@ template<typename DType, typename LType>
 class DataLoader{
 private:
     Dataset<DType, LType>* ptr_dataset;
+    RowBuffer<DType, LType>* ptr_rows;          //not null: rows are copied directly from memory (see: gather)
+    size_t data_row, label_row;                 //number of elements in one sample
     int dataset_len;
-    Batch <DType, LType>* batch;
+    int batch_num;
     xt::xarray<unsigned long> index_list;
+    xt::xarray<unsigned long> batch_indices;    //indices of the batch being filled (see: fill_batch)
+    std::vector<int> batch_offsets;     //batch b: index_list[batch_offsets[b] .. batch_offsets[b+1]-1]
+    BatchSampler* batch_sampler;        //fills index_list and batch_offsets for each epoch
+    std::vector<Sampler*> own_samplers; //made (and deleted) by this loader
+    bool own_batch_sampler;
     int batch_size;
     bool shuffle;
     bool drop_last;
     int m_seed;
+    int epoch;                  //epoch of the next pass (see: begin, set_epoch)
+    int index_epoch;            //epoch that index_list was sampled for
+    xt::random::default_engine_type engine;     //owned by this loader: loaders do not share random state
     /*TODO: add more member variables to support the iteration*/
+    //prefetching (prefetch_factor > 0): a producer thread fills "ready" (a ring of prefetch_factor batches)
+    int prefetch_factor;
+    std::thread producer;
+    std::mutex queue_mutex;
+    std::condition_variable not_empty, not_full;
+    std::vector<Batch<DType, LType>> ready;
+    std::vector<int> ready_index;       //ready_index[i]: batch_idx of the batch in ready[i]
+    int ready_head, ready_count;
+    bool stop_producer;
+    std::exception_ptr producer_error;
+    int active_iterators;       //Iterators between begin() and end() (see: set_transform)
+    //parallel collation (num_workers > 0): the samples of a batch are fetched by a pool of threads
+    WorkerPool* pool;
+    //buffer reuse: batches given back by the iteration (see: release_batch), to be filled again
+    std::vector<Batch<DType, LType>> free_batches;
+    std::mutex free_mutex;
+    //transform applied while the batches are assembled (see: set_transform)
+    Transform<DType, LType> transform;
+    bool transform_data, transform_label;
+    xt::xarray<LType> label_ids;        //class ids of the batch being filled, before one_hot
+    Batch<DType, LType> rows_block;     //a few rows read by getitems, before the transform (see: fill_batch)
 public:
+    /* DataLoader:
+     * only the order of samples (index_list) is computed here;
+     * each batch is assembled when the iteration reaches it (see: get_batch)
+     *  + prefetch_factor > 0: a background thread assembles up to prefetch_factor batches
+     *      ahead of the iteration, so loading overlaps with the work done on each batch
+     *  + num_workers > 0: the samples of each batch are fetched by num_workers threads;
+     *      each sample is written to its own row => the batches do not depend on the threads
+     *      NOTE: Dataset::getitem must be safe to call from several threads at once
+     *  + shuffle == true: each pass (begin) reshuffles index_list, see: set_epoch
+     *      (shuffle == false: SequentialSampler, shuffle == true: RandomSampler,
+     *      or ChunkSampler for a ChunkedRows dataset, to keep its reads sequential)
+     *      the loader has its own random engine, seeded by "seed" (by std::random_device if seed < 0);
+     *      the global one (xt::random) is not used => loaders can be built and run in parallel
+     *  + world_size > 1: this loader only reads the shard "rank" of each pass (see: DistributedSampler);
+     *      all the ranks must use the same seed (>= 0) to agree on the order;
+     *      drop_last == true: the shards are disjoint (the last len % world_size samples of the order
+     *      are left out), drop_last == false: the last shards wrap around to the first samples
+     *  + the tensors of a batch are recycled once the iteration moves past it:
+     *      after the first pass, iterating a TensorDataset does not allocate
+     *      (use "auto&" in for-each to keep it so: "auto" copies each batch)
+     */
     DataLoader(Dataset<DType, LType>* ptr_dataset,
         int batch_size,
         bool shuffle = true,
-        bool drop_last = false, int seed = -1) :  batch_size(batch_size), shuffle(shuffle), drop_last(drop_last), m_seed(seed) {
+        bool drop_last = false, int seed = -1,
+        int prefetch_factor = 0, int num_workers = 0,
+        int rank = 0, int world_size = 1) :  batch_size(batch_size), shuffle(shuffle), drop_last(drop_last), m_seed(seed),
+        epoch(0), index_epoch(0), prefetch_factor(prefetch_factor), ready(prefetch_factor > 0 ? prefetch_factor : 0),
+        ready_head(0), ready_count(0), stop_producer(false) {
         /*TODO: Add your code to do the initialization */
-        this->ptr_dataset = ptr_dataset;
-        dataset_len = ptr_dataset->len();
-        int batch_num = dataset_len / batch_size;       //Calculate how many batch
-        batch = new Batch<DType, LType>[batch_num];
-        index_list = xt::arange(dataset_len);
-        if (m_seed >= 0) {
-            xt::random::seed(m_seed);
+        if (world_size > 1 && shuffle && seed < 0)
+            throw std::invalid_argument("Sharded loading with shuffle needs the same seed (>= 0) on all ranks!");
+        if (world_size < 1 || rank < 0 || rank >= world_size)
+            throw std::out_of_range("rank must be in [0, world_size)!");     //before any sampler is allocated
+        int len = ptr_dataset->len();
+        ChunkedRows* chunked = dynamic_cast<ChunkedRows*>(ptr_dataset);
+        if (shuffle && chunked != 0) own_samplers.push_back(new ChunkSampler(len, chunked->chunk_rows(), chunked->window_chunks()));
+        else if (shuffle) own_samplers.push_back(new RandomSampler(len));
+        else own_samplers.push_back(new SequentialSampler(len));
+        if (world_size > 1) own_samplers.push_back(new DistributedSampler(own_samplers.back(), rank, world_size, drop_last));
+        batch_sampler = new BatchSampler(own_samplers.back(), batch_size, drop_last);
+        own_batch_sampler = true;
+        setup(ptr_dataset, num_workers);
+    }
+    /* DataLoader(ptr_dataset, sampler, batch_size, ...): the order of the samples comes from "sampler"
+     *      (e.g., WeightedRandomSampler to balance the classes); a new order for each epoch
+     * DataLoader(ptr_dataset, batch_sampler, ...): the batches come from "batch_sampler"
+     * NOTE: the samplers are not deleted by the loader
+     */
+    DataLoader(Dataset<DType, LType>* ptr_dataset,
+        Sampler* sampler, int batch_size,
+        bool drop_last = false, int seed = -1,
+        int prefetch_factor = 0, int num_workers = 0) :  batch_size(batch_size), shuffle(true), drop_last(drop_last), m_seed(seed),
+        epoch(0), index_epoch(0), prefetch_factor(prefetch_factor), ready(prefetch_factor > 0 ? prefetch_factor : 0),
+        ready_head(0), ready_count(0), stop_producer(false) {
+        batch_sampler = new BatchSampler(sampler, batch_size, drop_last);
+        own_batch_sampler = true;
+        setup(ptr_dataset, num_workers);
+    }
+    DataLoader(Dataset<DType, LType>* ptr_dataset,
+        BatchSampler* batch_sampler, int seed = -1,
+        int prefetch_factor = 0, int num_workers = 0) :  batch_size(0), shuffle(true), drop_last(false), m_seed(seed),
+        epoch(0), index_epoch(0), prefetch_factor(prefetch_factor), ready(prefetch_factor > 0 ? prefetch_factor : 0),
+        ready_head(0), ready_count(0), stop_producer(false) {
+        this->batch_sampler = batch_sampler;
+        own_batch_sampler = false;
+        setup(ptr_dataset, num_workers);
+    }
+    virtual ~DataLoader(){
+        stop_prefetch();
+        delete pool;
+        release_samplers();
+    }
+
+    /* set_epoch(int epoch): the next pass (begin) is the one of "epoch"
+     *  + each pass moves to the next epoch, so for-each over the same loader
+     *      gives a new order every time without building a new DataLoader
+     *  + with seed >= 0, the order of an epoch only depends on (seed, epoch):
+     *      epoch 0 is the order computed by the constructor
+     */
+    void set_epoch(int epoch){
+        this->epoch = epoch;
+    }
+    int get_epoch(){
+        return epoch;
+    }
+
+    /* set_transform(transform): apply "transform" to the samples of the next batches (see: Transform)
+     *  + the data steps run while each row is copied into the batch: one pass per row
+     *  + one_hot: the label of a batch becomes (batch size, num_classes)
+     *  + the transform is copied; call it between passes (a pass left with "break" is over:
+     *      its prefetched batches, assembled with the previous transform, are dropped)
+     *  >> throw an exception (std::invalid_argument) if one_hot is used and the samples do not have
+     *      a single label value, or if a parameter does not fit the samples
+     *  >> throw an exception (std::logic_error) if an Iterator is still in the middle of a pass
+     */
+    void set_transform(const Transform<DType, LType>& transform){
+        if (active_iterators > 0) throw std::logic_error("set_transform during a pass!");
+        Transform<DType, LType> copy = transform;
+        copy.prepare(data_row);
+        if (copy.num_classes() > 0 && (ptr_dataset->get_label_shape().size() == 0 || label_row != 1))
+            throw std::invalid_argument("one_hot needs one class id per sample!");
+        stop_prefetch();        //the producer reads the transform
+        this->transform = copy;
+        transform_data = copy.has_data_steps();
+        transform_label = copy.num_classes() > 0;
+    }
+
+    /* get_batch_num(): number of batches in one pass over the dataset
+     */
+    int get_batch_num(){
+        return batch_num;
+    }
+
+    /* get_worker_utilization(): for each worker, the fraction of time spent fetching samples
+     *      (empty if num_workers == 0)
+     */
+    xt::xarray<double> get_worker_utilization(){
+        int num_workers = pool == 0 ? 0 : pool->size();
+        xt::xarray<double> result = xt::zeros<double>({(size_t)num_workers});
+        for (int idx = 0; idx < num_workers; idx++) result(idx) = pool->utilization(idx);
+        return result;
+    }
+
+    /* get_batch(int batch_idx):
+     * assemble the batch at position batch_idx (0 <= batch_idx < batch_num):
+     *  + batch_size samples, taken in the order of index_list
+     *  + if drop_last == false: the last batch also takes the remaining samples
+     *  (with a BatchSampler: the samples it gives for batch_idx)
+     */
+    Batch<DType, LType> get_batch(int batch_idx){
+        Batch<DType, LType> batch;
+        fill_batch(batch_idx, batch);
+        return batch;
+    }
+
+    /* get_batch_view(int batch_idx): the batch at batch_idx, without copying the samples if possible:
+     *  + RowBuffer dataset (e.g., TensorDataset, NpyDataset) whose samples batch_idx are
+     *      consecutive rows (e.g., shuffle == false): the tensors of the batch point into its memory
+     *  + otherwise: the batch is assembled as in get_batch
+     */
+    BatchView<DType, LType> get_batch_view(int batch_idx){
+        int start = batch_offsets[batch_idx];
+        int size = batch_rows(batch_idx);
+        auto datas = ptr_dataset->get_data_shape();
+        auto labels = ptr_dataset->get_label_shape();
+        bool direct = rows_direct(labels) && size > 0 && !transform_data && !transform_label;
+        for (int j = 1; direct && j < size; j++) direct = index_list[start + j] == index_list[start] + j;
+        if (!direct) return BatchView<DType, LType>(get_batch(batch_idx));
+
+        size_t first = index_list[start];
+        xt::svector<size_t> data_shape(datas.begin(), datas.end());
+        data_shape[0] = size;
+        DType* data_ptr = ptr_rows->data_rows() + first * data_row;
+        if (labels.size() == 0) {
+            Batch<DType, LType> scalar(xt::xarray<DType>(), xt::xarray<LType>(0));
+            return BatchView<DType, LType>(data_ptr, data_shape, 0, xt::svector<size_t>(), std::move(scalar));
+        }
+        xt::svector<size_t> label_shape(labels.begin(), labels.end());
+        label_shape[0] = size;
+        LType* label_ptr = ptr_rows->label_rows() + first * label_row;
+        return BatchView<DType, LType>(data_ptr, data_shape, label_ptr, label_shape);
+    }
+
+    /* fill_batch(int batch_idx, Batch& batch): same as get_batch, but write into "batch";
+     *      its tensors are reused when they already have the right number of elements
+     *  + RowBuffer dataset: rows are copied directly (see: gather)
+     *  + otherwise: Dataset::getitems, or getitem for each sample on the workers if num_workers > 0
+     *  + with a transform (see: set_transform): each row is transformed as it is copied into the batch,
+     *      from the memory of the dataset (RowBuffer), from the sample given by getitem,
+     *      or from a block of rows read by getitems that fits in cache (see: rows_block);
+     *      the class ids are collected in label_ids, then encoded into the label of the batch
+     */
+    void fill_batch(int batch_idx, Batch<DType, LType>& batch){
+        int start = batch_offsets[batch_idx];
+        int size = batch_rows(batch_idx);
+
+        auto datas = ptr_dataset->get_data_shape();
+        auto labels = ptr_dataset->get_label_shape();
+        bool direct = rows_direct(labels);
+        datas[0] = size;
+        xt::xarray<DType>& data = batch.getData();
+        xt::xarray<LType>& label = batch.getLabel();
+        xt::xarray<LType>& ids = transform_label ? label_ids : label;     //where the labels of the samples go
+        data.resize(datas);
+        if (labels.size() == 0) {
+            if (label.dimension() != 0 || label.storage().size() != 1) label = xt::xarray<LType>(0);
+            *label.data() = 0;
+        }
+        else {
+            labels[0] = size;
+            ids.resize(labels);
+        }
+        if (direct) {
+            if (transform_data) {
+                const DType* src = ptr_rows->data_rows();
+                DType* dst = data.data();
+                collate(size, [&](int j) {
+                    transform.apply(dst + j * data_row, src + index_list[start + j] * data_row);
+                });
+            }
+            else gather(ptr_rows->data_rows(), data_row, data, start, size);
+            if (labels.size() != 0) gather(ptr_rows->label_rows(), label_row, ids, start, size);
+            encode_labels(label, size);
+            return;
+        }
+        if (pool == 0 && transform_data) get_rows_transformed(start, size, data, ids, labels.size() != 0);
+        else if (pool == 0) {
+            batch_indices = xt::view(index_list, xt::range(start, start + size));
+            if (transform_label) std::swap(label, label_ids);       //getitems writes the ids into label_ids
+            ptr_dataset->getitems(batch_indices, batch);
+            if (transform_label) std::swap(label, label_ids);
+        }
+        else if (labels.size() == 0) {
+            collate(size, [&](int j) {
+                DataLabel<DType, LType> item = ptr_dataset->getitem(index_list[start + j]);
+                put_row(data, j, item.getData());
+            });
         }
-        if (shuffle)    xt::random::shuffle(index_list);
-        int index_cur = 0;
-        for (int i = 0; i < batch_num; i++) {
-            int index = index_list[index_cur];
+        else {
+            collate(size, [&](int j) {
+                DataLabel<DType, LType> item = ptr_dataset->getitem(index_list[start + j]);
+                put_row(data, j, item.getData());
+                xt::view(ids, j) = item.getLabel();
+            });
+        }
+        encode_labels(label, size);
+    }
+
+private:
+    void setup(Dataset<DType, LType>* ptr_dataset, int num_workers){
+        this->ptr_dataset = ptr_dataset;
+        transform_data = transform_label = false;
+        active_iterators = 0;
+        pool = 0;
+        ready_index.resize(ready.size());
+        try {
+            ptr_rows = dynamic_cast<RowBuffer<DType, LType>*>(ptr_dataset);
+            dataset_len = ptr_dataset->len();
             auto datas = ptr_dataset->get_data_shape();
             auto labels = ptr_dataset->get_label_shape();
-            datas[0] = batch_num; labels[0] = batch_num;
-            xt::xarray<DType> data = xt::empty<DType>(datas);
-            xt::xarray<LType> label = xt::empty<LType>(labels);
-            int label_dim = label.dimension();
-            if (label_dim == 0) {
-                if (!drop_last && i == batch_num - 1) {
-                    int len = dataset_len - batch_size * batch_num;
-                    datas[0] += len;
-                    xt::xarray<DType> data = xt::empty<DType>(datas);
-                    for (int j = 0; j < batch_size + len; j++)
-                    {
-                        xt::view(data, j) = ptr_dataset->getitem(index).getData();
-                        index_cur++;
-                        batch[i] = Batch<DType, LType>(data, 0);
-                        index = index_list[index_cur];
-                    }
-                }
-                else {
-                    for (int j = 0; j < batch_size; j++) {
-                        xt::view(data, j) = ptr_dataset->getitem(index).getData();
-                        index_cur++;
-                        batch[i] = Batch<DType, LType>(data, 0);
-                        index = index_list[index_cur];
-                    }
-                }
+            data_row = label_row = 1;
+            for (size_t idx = 1; idx < datas.size(); idx++) data_row *= datas[idx];
+            for (size_t idx = 1; idx < labels.size(); idx++) label_row *= labels[idx];
+            reshuffle(0);
+            pool = num_workers > 0 ? new WorkerPool(num_workers) : 0;
+        }
+        catch (...) {
+            release_samplers();     //the destructor does not run if the constructor throws
+            throw;
+        }
+        free_batches.reserve(2 * (prefetch_factor + 2));
+    }
+
+    void release_samplers(){
+        if (own_batch_sampler) delete batch_sampler;
+        for (size_t idx = 0; idx < own_samplers.size(); idx++) delete own_samplers[idx];
+        batch_sampler = 0;
+        own_samplers.clear();
+    }
+
+    /* start_pass(): stop the prefetching of the previous pass, order index_list for the current epoch
+     *      and move to the next epoch
+     */
+    void start_pass(){
+        stop_prefetch();
+        if (shuffle && epoch != index_epoch) reshuffle(epoch);
+        epoch++;
+    }
+
+    /* reshuffle(int epoch): index_list and the batches for "epoch", from the batch sampler
+     *      only the order is rebuilt, not the batches
+     */
+    void reshuffle(int epoch){
+        if (m_seed >= 0) {
+            unsigned int mixed = (unsigned int)m_seed ^ ((unsigned int)epoch * 0x9E3779B9u);
+            engine.seed(mixed);
+        }
+        else engine.seed(std::random_device()());
+        batch_sampler->sample(index_list, batch_offsets, engine);
+        check_indices();
+        batch_num = (int)batch_offsets.size() - 1;      //Calculate how many batch
+        index_epoch = epoch;
+    }
+
+    /* check_indices(): the order given by the (batch) sampler fits the dataset;
+     *      once per epoch, so that gather and getitem can trust index_list
+     *  >> throw an exception (std::out_of_range) if an index is >= dataset_len
+     *      or the batch offsets are not increasing within index_list
+     */
+    void check_indices(){
+        const unsigned long* indices = index_list.data();
+        size_t count = index_list.size();
+        for (size_t idx = 0; idx < count; idx++)
+            if (indices[idx] >= (unsigned long)dataset_len)
+                throw std::out_of_range("Sampler index is out of range of the dataset!");
+        if (batch_offsets.empty() || batch_offsets[0] < 0 || batch_offsets.back() > (int)count)
+            throw std::out_of_range("Batch offsets are out of range!");
+        for (size_t b = 1; b < batch_offsets.size(); b++)
+            if (batch_offsets[b] < batch_offsets[b - 1])
+                throw std::out_of_range("Batch offsets are out of range!");
+    }
+
+    /* batch_rows(int batch_idx): number of samples in the batch at batch_idx
+     */
+    int batch_rows(int batch_idx){
+        return batch_offsets[batch_idx + 1] - batch_offsets[batch_idx];
+    }
+
+    /* acquire_batch(int size): a batch given back earlier whose tensors hold "size" samples
+     *      (an empty Batch if there is none: its tensors are allocated by fill_batch)
+     * release_batch(batch): give the tensors of "batch" back, to be filled again
+     */
+    Batch<DType, LType> acquire_batch(int size){
+        std::lock_guard<std::mutex> lock(free_mutex);
+        for (size_t idx = 0; idx < free_batches.size(); idx++) {
+            xt::xarray<DType>& data = free_batches[idx].getData();
+            if (data.dimension() > 0 && (int)data.shape()[0] == size) {
+                Batch<DType, LType> batch = std::move(free_batches[idx]);
+                if (idx + 1 < free_batches.size()) free_batches[idx] = std::move(free_batches.back());
+                free_batches.pop_back();
+                return batch;
+            }
+        }
+        return Batch<DType, LType>();
+    }
+    void release_batch(Batch<DType, LType>&& batch){
+        std::lock_guard<std::mutex> lock(free_mutex);
+        if (free_batches.size() < free_batches.capacity()) free_batches.push_back(std::move(batch));
+    }
+
+    /* encode_labels(label, size): label = one-hot rows of label_ids (if the transform has one_hot)
+     */
+    void encode_labels(xt::xarray<LType>& label, int size){
+        if (!transform_label) return;
+        label.resize({(size_t)size, (size_t)transform.num_classes()});
+        transform.encode(label_ids.data(), size, label.data());
+    }
+
+    /* collate(int size, fill_row): call fill_row(j) for the rows j = 0..size-1 of a batch,
+     *      on the worker pool if any
+     */
+    template<typename Fill>
+    void collate(int size, Fill fill_row){
+        if (pool == 0) {
+            for (int j = 0; j < size; j++) fill_row(j);
+        }
+        else pool->run(size, fill_row);
+    }
+
+    /* put_row(data, j, sample): row j of data = sample, through the transform if it has data steps
+     *      (a sample that is not one row of data_row elements is assigned, then transformed in place)
+     */
+    void put_row(xt::xarray<DType>& data, int j, const xt::xarray<DType>& sample){
+        DType* dst = data.data() + j * data_row;
+        if (transform_data && sample.size() == data_row) {
+            transform.apply(dst, sample.data());
+            return;
+        }
+        xt::view(data, j) = sample;
+        if (transform_data) transform.apply(dst, dst);
+    }
+
+    /* get_rows_transformed(start, size, data, ids, labelled): the samples of a batch through getitems,
+     *      a block of rows at a time (about 32 KB, in rows_block); each row of the block is
+     *      transformed into data while the block is still in cache, its label copied into ids
+     */
+    void get_rows_transformed(int start, int size, xt::xarray<DType>& data, xt::xarray<LType>& ids, bool labelled){
+        int block = (int)std::max<size_t>(1, ((size_t)32 << 10) / std::max<size_t>(1, data_row * sizeof(DType)));
+        for (int first = 0; first < size; first += block) {
+            int count = std::min(block, size - first);
+            batch_indices = xt::view(index_list, xt::range(start + first, start + first + count));
+            ptr_dataset->getitems(batch_indices, rows_block);
+            const DType* src = rows_block.getData().data();
+            for (int j = 0; j < count; j++)
+                transform.apply(data.data() + (first + j) * data_row, src + j * data_row);
+            if (labelled)
+                copy_row(ids.data() + first * label_row, rows_block.getLabel().data(), count * label_row,
+                    typename std::is_trivially_copyable<LType>::type());
+        }
+    }
+
+    /* rows_direct(labels): true if the rows can be read from the memory of the dataset
+     *      (RowBuffer, and one label row per sample if there are labels)
+     */
+    bool rows_direct(xt::svector<unsigned long>& labels){
+        if (ptr_rows == 0 || ptr_rows->data_rows() == 0) return false;
+        if (labels.size() == 0) return true;
+        return labels[0] == (unsigned long)dataset_len && ptr_rows->label_rows() != 0;
+    }
+
+    /* gather(source, row, target, start, size):
+     * target[j] = source[index_list[start + j]] for j = 0..size-1, "row" elements per sample;
+     * rows of a row-major buffer are contiguous => one copy per row, no temporary tensor
+     */
+    template<typename T>
+    void gather(const T* src, size_t row, xt::xarray<T>& target, int start, int size){
+        T* dst = target.data();
+        collate(size, [&](int j) {
+            copy_row(dst + j * row, src + index_list[start + j] * row, row,
+                typename std::is_trivially_copyable<T>::type());
+        });
+    }
+    template<typename T>
+    static void copy_row(T* dst, const T* src, size_t n, std::true_type){
+        std::memcpy(dst, src, n * sizeof(T));
+    }
+    template<typename T>
+    static void copy_row(T* dst, const T* src, size_t n, std::false_type){
+        std::copy(src, src + n, dst);
+    }
+
+    /* next_batch(int batch_idx): the batch for the iteration at batch_idx
+     *  + without prefetching: assemble it now, in a recycled batch if possible
+     *  + with prefetching: take it from the queue; the batches before it that were
+     *      never accessed (iterator moved on without *) are given back (see: release_batch)
+     *  >> throw an exception (std::logic_error) if the queue has already gone past batch_idx
+     */
+    Batch<DType, LType> next_batch(int batch_idx){
+        if (prefetch_factor <= 0) {
+            Batch<DType, LType> batch = acquire_batch(batch_rows(batch_idx));
+            fill_batch(batch_idx, batch);
+            return batch;
+        }
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        while (true) {
+            not_empty.wait(lock, [this]{ return ready_count > 0 || producer_error; });
+            if (ready_count == 0) std::rethrow_exception(producer_error);
+            int index = ready_index[ready_head];
+            if (index > batch_idx) throw std::logic_error("The prefetched batch was already consumed!");
+            Batch<DType, LType> batch = std::move(ready[ready_head]);
+            ready_head = (ready_head + 1) % prefetch_factor;
+            ready_count--;
+            not_full.notify_one();
+            if (index == batch_idx) return batch;
+            release_batch(std::move(batch));        //skipped by the iteration
+        }
+    }
+    void start_prefetch(){
+        stop_prefetch();
+        stop_producer = false;
+        producer_error = nullptr;
+        producer = std::thread(&DataLoader<DType, LType>::prefetch_loop, this);
+    }
+    void stop_prefetch(){
+        if (producer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                stop_producer = true;
+            }
+            not_full.notify_all();
+            producer.join();
+        }
+        for (; ready_count > 0; ready_count--) {
+            release_batch(std::move(ready[ready_head]));
+            ready_head = (ready_head + 1) % prefetch_factor;
+        }
+        ready_head = 0;
+    }
+    void prefetch_loop(){
+        for (int batch_idx = 0; batch_idx < batch_num; batch_idx++) {
+            Batch<DType, LType> batch = acquire_batch(batch_rows(batch_idx));
+            try {
+                fill_batch(batch_idx, batch);
             }
-            else {
-                if (!drop_last && i == batch_num - 1) {
-                    int len = dataset_len - batch_size * batch_num;
-                    datas[0] += len; labels[0] += len;
-                    xt::xarray<DType> data = xt::empty<DType>(datas);
-                    xt::xarray<LType> label = xt::empty<LType>(labels);
-                    for (int j = 0; j < batch_size + len; j++)
-                    {
-                        xt::view(data, j) = ptr_dataset->getitem(index).getData();
-                        xt::view(label, j) = ptr_dataset->getitem(index).getLabel();
-                        index_cur++;
-                        batch[i] = Batch<DType, LType>(data, label);
-                        index = index_list[index_cur];
-                    }
-                }
-                else {
-                    for (int j = 0; j < batch_size; j++) {
-                        xt::view(data, j) = ptr_dataset->getitem(index).getData();
-                        xt::view(label, j) = ptr_dataset->getitem(index).getLabel();
-                        index_cur++;
-                        batch[i] = Batch<DType, LType>(data, label);
-                        index = index_list[index_cur];
-                    }
-                }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                producer_error = std::current_exception();
+                not_empty.notify_all();
+                return;
             }
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            not_full.wait(lock, [this]{ return stop_producer || ready_count < prefetch_factor; });
+            if (stop_producer) return;
+            ready[(ready_head + ready_count) % prefetch_factor] = std::move(batch);
+            ready_index[(ready_head + ready_count) % prefetch_factor] = batch_idx;
+            ready_count++;
+            not_empty.notify_one();
         }
     }
-    virtual ~DataLoader(){}
 
     /////////////////////////////////////////////////////////////////////////
     // The section for supporting the iteration and for-each to DataLoader //
@@ -112,20 +563,40 @@ public:
     /*TODO: Add your code here to support iteration on batch*/
 public:
     // Iterator: BEGIN
+    // the batch at cursor is assembled on the first access and kept until ++,
+    // then its tensors go back to the loader (see: release_batch)
+    // an Iterator before the end is counted by its loader (see: active_iterators)
     class Iterator
     {
     private:
         int cursor;
-        Batch<DType, LType> *batch_list;
+        DataLoader<DType, LType>* pLoader;
+        Batch<DType, LType> current;
+        bool loaded;
+        bool active;
     public:
-        Iterator(Batch<DType, LType>* bList = 0, int index = 0) {
-            this->batch_list = bList;
+        Iterator(DataLoader<DType, LType>* pLoader = 0, int index = 0) {
+            this->pLoader = pLoader;
             this->cursor = index;
+            this->loaded = false;
+            this->active = false;
+            activate();
+        }
+        Iterator(const Iterator& iterator): cursor(iterator.cursor), pLoader(iterator.pLoader),
+            current(iterator.current), loaded(iterator.loaded), active(false) {
+            activate();
+        }
+        ~Iterator() {
+            deactivate();
         }
 
         Iterator& operator=(const Iterator& iterator) {
+            deactivate();
             cursor = iterator.cursor;
-            batch_list = iterator.batch_list;
+            pLoader = iterator.pLoader;
+            current = iterator.current;
+            loaded = iterator.loaded;
+            activate();
             return *this;
         }
 
@@ -134,11 +605,18 @@ public:
         }
 
         Batch<DType, LType>& operator*() {
-            return batch_list[cursor];
+            if (!loaded) {
+                current = pLoader->next_batch(cursor);
+                loaded = true;
+            }
+            return current;
         }
 
         Iterator& operator++() {
             this->cursor++;
+            if (loaded) pLoader->release_batch(std::move(current));
+            loaded = false;
+            if (cursor >= pLoader->batch_num) deactivate();
             return *this;
         }
 
@@ -148,6 +626,15 @@ public:
             return iterator;
         }
 
+    private:
+        void activate() {
+            active = pLoader != 0 && cursor < pLoader->batch_num;
+            if (active) pLoader->active_iterators++;
+        }
+        void deactivate() {
+            if (active) pLoader->active_iterators--;
+            active = false;
+        }
         // Iterator: END
     };
     /////////////////////////////////////////////////////////////////////////
@@ -155,12 +642,231 @@ public:
     /// END: Section                                                       //
     /////////////////////////////////////////////////////////////////////////
 
+    /* begin(): start a new pass over the dataset, the pass of the current epoch
+     *      with prefetching, the producer of an unfinished pass is stopped and a new one starts
+     */
     Iterator begin() {
-        return Iterator(this->batch, 0);
+        start_pass();
+        if (prefetch_factor > 0) start_prefetch();
+        return Iterator(this, 0);
     }
 
     Iterator end() {
-        return Iterator(this->batch, (dataset_len / batch_size));
+        return Iterator(this, batch_num);
+    }
+
+    // ViewIterator: BEGIN
+    // same as Iterator, but the batches are BatchView (see: get_batch_view); no prefetching
+    class ViewIterator
+    {
+    private:
+        int cursor;
+        DataLoader<DType, LType>* pLoader;
+        BatchView<DType, LType> current;
+        bool loaded;
+    public:
+        ViewIterator(DataLoader<DType, LType>* pLoader = 0, int index = 0) {
+            this->pLoader = pLoader;
+            this->cursor = index;
+            this->loaded = false;
+        }
+        bool operator!=(const ViewIterator& iterator) {
+            return cursor != iterator.cursor;
+        }
+        BatchView<DType, LType>& operator*() {
+            if (!loaded) {
+                current = pLoader->get_batch_view(cursor);
+                loaded = true;
+            }
+            return current;
+        }
+        ViewIterator& operator++() {
+            this->cursor++;
+            loaded = false;
+            return *this;
+        }
+        ViewIterator operator++(int) {
+            ViewIterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+    };
+    // ViewIterator: END
+
+    /* views(): for-each over one pass, with the batches as BatchView
+     * Example: evaluation over a large TensorDataset, without copying it
+     *      DataLoader<double, double> loader(&ds, 256, false);
+     *      for (auto& batch : loader.views()) model.predict(batch.getData());
+     */
+    class Views
+    {
+    private:
+        DataLoader<DType, LType>* pLoader;
+    public:
+        Views(DataLoader<DType, LType>* pLoader): pLoader(pLoader) {}
+        ViewIterator begin() {
+            pLoader->start_pass();
+            return ViewIterator(pLoader, 0);
+        }
+        ViewIterator end() {
+            return ViewIterator(pLoader, pLoader->batch_num);
+        }
+    };
+    Views views() {
+        return Views(this);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* IterableLoader: batches from an IterableDataset, in constant memory
+ *  + shuffle_buffer > 1: samples go through a buffer of shuffle_buffer samples;
+ *      each output sample is a random one of the buffer, replaced by the next of the stream
+ *      => the order is shuffled locally (within about shuffle_buffer samples), memory stays bounded
+ *  + batches follow DataLoader: batch_size samples, and if drop_last == false the last batch
+ *      also takes the remaining samples (a stream shorter than batch_size gives no batch);
+ *      so up to 2*batch_size-1 samples are held back to know which batch is the last one
+ *  + each pass (begin) resets the stream; with seed >= 0 the order of an epoch
+ *      only depends on (seed, epoch), as in DataLoader
+ *  + single pass iterator: the batch of the iteration is kept by the loader
+ *      and reused by the next one (use "auto&" in for-each)
+ */
+template<typename DType, typename LType>
+class IterableLoader{
+private:
+    struct Sample{
+        xt::xarray<DType> data;
+        xt::xarray<LType> label;
+    };
+    IterableDataset<DType, LType>* ptr_dataset;
+    int batch_size;
+    int shuffle_buffer;
+    bool drop_last;
+    int m_seed;
+    int epoch;
+    xt::random::default_engine_type engine;
+    std::vector<Sample> buffer;     //shuffle buffer
+    std::deque<Sample> pending;     //samples read ahead, in output order
+    Sample spare;                   //storage reused for the next sample read
+    bool stream_done;
+    Batch<DType, LType> current;
+    bool finished;
+
+public:
+    IterableLoader(IterableDataset<DType, LType>* ptr_dataset,
+        int batch_size, int shuffle_buffer = 0,
+        bool drop_last = false, int seed = -1):
+    ptr_dataset(ptr_dataset), batch_size(batch_size), shuffle_buffer(shuffle_buffer),
+    drop_last(drop_last), m_seed(seed), epoch(0), stream_done(true), finished(true){
+        if (shuffle_buffer > 1) buffer.reserve(shuffle_buffer);
+    }
+
+    void set_epoch(int epoch){ this->epoch = epoch; }
+    int get_epoch(){ return epoch; }
+
+    // Iterator: BEGIN
+    class Iterator
+    {
+    private:
+        IterableLoader<DType, LType>* pLoader;
+    public:
+        Iterator(IterableLoader<DType, LType>* pLoader = 0): pLoader(pLoader) {}
+        bool operator!=(const Iterator& iterator) {
+            bool done = pLoader == 0 || pLoader->finished;
+            bool other_done = iterator.pLoader == 0 || iterator.pLoader->finished;
+            return done != other_done;
+        }
+        Batch<DType, LType>& operator*() {
+            return pLoader->current;
+        }
+        Iterator& operator++() {
+            pLoader->advance();
+            return *this;
+        }
+    };
+    // Iterator: END
+
+    /* begin(): reset the stream and start the pass of the current epoch
+     */
+    Iterator begin() {
+        if (m_seed >= 0) engine.seed((unsigned int)m_seed ^ ((unsigned int)epoch * 0x9E3779B9u));
+        else engine.seed(std::random_device()());
+        epoch++;
+        ptr_dataset->reset();
+        buffer.clear();
+        pending.clear();
+        stream_done = false;
+        finished = false;
+        advance();
+        return Iterator(this);
+    }
+    Iterator end() {
+        return Iterator(0);
+    }
+
+private:
+    /* advance(): assemble the next batch into "current", or set finished
+     */
+    void advance(){
+        //read ahead until this batch is known not to be the last one, or the stream ends
+        while (!stream_done && (int)pending.size() < 2 * batch_size) {
+            Sample sample;
+            if (!pull(sample)) stream_done = true;
+            else pending.push_back(std::move(sample));
+        }
+        int size = batch_size;
+        if (stream_done && (int)pending.size() < 2 * batch_size && !drop_last) size = (int)pending.size();
+        if ((int)pending.size() < batch_size || size == 0) {
+            finished = true;
+            return;
+        }
+        collate(size);
+    }
+
+    /* pull(sample): the next sample after the shuffle buffer; false at the end
+     */
+    bool pull(Sample& sample){
+        if (shuffle_buffer <= 1) return ptr_dataset->next(sample.data, sample.label);
+        while (!stream_done && (int)buffer.size() < shuffle_buffer) {
+            if (!ptr_dataset->next(spare.data, spare.label)) break;
+            buffer.push_back(std::move(spare));
+        }
+        if (buffer.empty()) return false;
+        std::uniform_int_distribution<int> dist(0, (int)buffer.size() - 1);
+        int pick = dist(engine);
+        sample = std::move(buffer[pick]);
+        if (!ptr_dataset->next(buffer[pick].data, buffer[pick].label)) {
+            buffer[pick] = std::move(buffer.back());
+            buffer.pop_back();
+        }
+        return true;
+    }
+
+    /* collate(int size): current = the first "size" pending samples, stacked along dimension 0
+     */
+    void collate(int size){
+        Sample& first = pending.front();
+        xt::svector<size_t> data_shape(1, size), label_shape(1, size);
+        data_shape.insert(data_shape.end(), first.data.shape().begin(), first.data.shape().end());
+        label_shape.insert(label_shape.end(), first.label.shape().begin(), first.label.shape().end());
+        bool labelled = ptr_dataset->has_label();
+        xt::xarray<DType>& data = current.getData();
+        xt::xarray<LType>& label = current.getLabel();
+        data.resize(data_shape);
+        if (labelled) label.resize(label_shape);
+        else {
+            if (label.dimension() != 0 || label.storage().size() != 1) label = xt::xarray<LType>(0);
+            *label.data() = 0;
+        }
+        size_t data_row = first.data.size(), label_row = first.label.size();
+        for (int j = 0; j < size; j++) {
+            Sample& sample = pending.front();
+            if (sample.data.size() != data_row || (labelled && sample.label.size() != label_row))
+                throw std::runtime_error("Samples of a batch have different shapes!");
+            std::copy(sample.data.data(), sample.data.data() + data_row, data.data() + j * data_row);
+            if (labelled) std::copy(sample.label.data(), sample.label.data() + label_row, label.data() + j * label_row);
+            spare = std::move(sample);
+            pending.pop_front();
+        }
     }
 };
 
@@ -15,11 +15,25 @@
 
 #include "XArrayList.h"
 #include "DLinkedList.h"
+#include "XIndexedList.h"
+#include "XSortedArrayList.h"
+#include "XHashMap.h"
+#include "XHashSet.h"
+#include "XHeap.h"
+#include "XTreeMap.h"
 //#include "SLinkedList.h"
 template<class T>
 using xvector = XArrayList<T>;
 template<class T>
 using xlist = DLinkedList<T>;
+template<class K, class V>
+using xmap = XHashMap<K, V>;
+template<class T>
+using xset = XHashSet<T>;
+template<class T>
+using xheap = XHeap<T>;
+template<class K, class V>
+using xtreemap = XTreeMap<K, V>;
 
 
 
@@ -2,11 +2,14 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <fstream>
 #include "listheader.h"
 #include "XArrayListDemo.h"
 #include "DLinkedListDemo.h"
+#include "XTreeMapDemo.h"
 #include "ann/xtensor_lib.h"
 #include "ann/dataset.h"
+#include "ann/csvdataset.h"
 #include "dataloader.h"
 using namespace std;
 
@@ -86,7 +89,7 @@ void case_data_wo_label_1() {
     delete pLoader;
 
     cout << "Loading (2): with shuffle=true + no seed (seed < 0):" << endl;
-    cout << "when seed < 0: DO NOT call xt::random:seed" << endl;
+    cout << "when seed < 0: the random engine of the loader gets a random seed" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = -1;
@@ -104,7 +107,7 @@ void case_data_wo_label_1() {
     delete pLoader;
 
     cout << "Loading (3): with shuffle=true + no seed (seed < 0):" << endl;
-    cout << "when seed < 0: DO NOT call xt::random:seed" << endl;
+    cout << "when seed < 0: the random engine of the loader gets a random seed" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = -1;
@@ -120,11 +123,11 @@ void case_data_wo_label_1() {
     }
     cout << endl << endl;
     delete pLoader;
-    cout << "NOTE: Loading (2) and (3): DO NOT CALL seed; so results are different." << endl;
+    cout << "NOTE: Loading (2) and (3): random seeds; so results are different." << endl;
     cout << endl << endl;
 
     cout << "Loading (4): with shuffle=true + with seed (seed >= 0):" << endl;
-    cout << "when seed >= 0: CALL xt::random:seed" << endl;
+    cout << "when seed >= 0: the random engine of the loader is seeded by seed" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = 100;
@@ -141,7 +144,7 @@ void case_data_wo_label_1() {
     delete pLoader;
 
     cout << "Loading (5): with shuffle=true + with seed (seed >= 0):" << endl;
-    cout << "when seed >= 0: CALL xt::random:seed" << endl;
+    cout << "when seed >= 0: the random engine of the loader is seeded by seed" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = 100;
@@ -156,7 +159,7 @@ void case_data_wo_label_1() {
         cout << "label:" << endl << batch.getLabel() << endl;
     }
     delete pLoader;
-    cout << "NOTE: Loading (4) and (5): CALL xt::random::seed and use SAME seed => same results." << endl;
+    cout << "NOTE: Loading (4) and (5): use SAME seed => same results." << endl;
     cout << endl << endl;
 }
 
@@ -201,7 +204,7 @@ void case_data_wi_label_1() {
     delete pLoader;
 
     cout << "Loading (2): with shuffle=true + no seed (seed < 0):" << endl;
-    cout << "when seed < 0: DO NOT call xt::random:seed" << endl;
+    cout << "when seed < 0: the random engine of the loader gets a random seed" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = -1;
@@ -219,7 +222,7 @@ void case_data_wi_label_1() {
     delete pLoader;
 
     cout << "Loading (3): with shuffle=true + no seed (seed < 0):" << endl;
-    cout << "when seed < 0: DO NOT call xt::random:seed" << endl;
+    cout << "when seed < 0: the random engine of the loader gets a random seed" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = -1;
@@ -235,11 +238,11 @@ void case_data_wi_label_1() {
     }
     cout << endl << endl;
     delete pLoader;
-    cout << "NOTE: Loading (2) and (3): DO NOT CALL seed; so results are different." << endl;
+    cout << "NOTE: Loading (2) and (3): random seeds; so results are different." << endl;
     cout << endl << endl;
 
     cout << "Loading (4): with shuffle=true + with seed (seed >= 0):" << endl;
-    cout << "when seed >= 0: CALL xt::random:seed" << endl;
+    cout << "when seed >= 0: the random engine of the loader is seeded by seed" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = 100;
@@ -257,7 +260,7 @@ void case_data_wi_label_1() {
     cout << endl << endl;
 
     cout << "Loading (5): with shuffle=true + with seed (seed >= 0):" << endl;
-    cout << "when seed >= 0: CALL xt::random:seed" << endl;
+    cout << "when seed >= 0: the random engine of the loader is seeded by seed" << endl;
     cout << "################################" << endl;
     shuffle = true;
     seed = 100;
@@ -272,7 +275,7 @@ void case_data_wi_label_1() {
         cout << "label:" << endl << batch.getLabel() << endl;
     }
     delete pLoader;
-    cout << "NOTE: Loading (4) and (5): CALL xt::random::seed and use SAME seed => same results." << endl;
+    cout << "NOTE: Loading (4) and (5): use SAME seed => same results." << endl;
     cout << endl << endl;
 }
 
@@ -319,6 +322,73 @@ void case_batch_larger_nsamples() {
     delete pLoader;
 
 
+}
+void case_distributed_drop_last() {
+    int nsamples = 10, world_size = 3, batch_size = 2;
+    xt::xarray<int> X = xt::arange<int>(nsamples * 2).reshape({ nsamples, 2 });
+    xt::xarray<int> t = xt::arange<int>(nsamples);
+    cout << "############################################" << endl;
+    cout << "#CASE: sharded loading (world_size=" << world_size << ") with drop_last=true" << endl;
+    cout << "each sample is read by at most one rank" << endl;
+    cout << "############################################" << endl;
+    TensorDataset<int, int> ds(X, t);
+    xt::xarray<int> reads = xt::zeros<int>({ nsamples });
+    for (int rank = 0; rank < world_size; rank++) {
+        DataLoader<int, int> loader(&ds, batch_size, true, true, 100, 0, 0, rank, world_size);
+        cout << "rank " << rank << ":";
+        for (auto& batch : loader) {
+            cout << " " << batch.getLabel();
+            for (size_t j = 0; j < batch.getLabel().size(); j++) reads(batch.getLabel()(j))++;
+        }
+        cout << endl;
+    }
+    cout << "shards are disjoint: " << (xt::amax(reads)() <= 1 ? "yes" : "NO") << endl;
+    cout << endl << endl;
+}
+void case_csv_long_field() {
+    //a field of more than 64 characters: still one number
+    string path = "csv_long_field.csv";
+    string field = "0." + string(100, '0') + "25e101";
+    ofstream out(path);
+    out << "x1,x2,y" << endl;
+    out << "1.5," << field << ",0" << endl;
+    out << "-2,-" << field << ",1" << endl;
+    out.close();
+    cout << "############################################" << endl;
+    cout << "#CASE: CSV with a field of " << field.size() << " characters" << endl;
+    cout << "############################################" << endl;
+    CsvDataset<double, int> ds(path, { -1 }, {}, true);
+    cout << "data:" << endl << ds.getitem(0).getData() << endl << ds.getitem(1).getData() << endl;
+    remove(path.c_str());
+    cout << endl << endl;
+}
+void case_transform_after_break() {
+    int nsamples = 10;
+    xt::xarray<double> X = xt::arange<double>(nsamples * 2).reshape({ nsamples, 2 });
+    xt::xarray<int> t = xt::arange<int>(nsamples);
+    cout << "############################################" << endl;
+    cout << "#CASE: set_transform after leaving a prefetched pass with break" << endl;
+    cout << "############################################" << endl;
+    TensorDataset<double, int> ds(X, t);
+    DataLoader<double, int> loader(&ds, 2, false, false, -1, 2);
+    for (auto& batch : loader) {
+        cout << "first batch, then break:" << endl << batch.getData() << endl;
+        break;
+    }
+    Transform<double, int> tf;
+    tf.scale(0.0, 10.0);
+    loader.set_transform(tf);
+    cout << "pass with scale(0, 10):" << endl;
+    for (auto& batch : loader) cout << batch.getData() << endl;
+    auto it = loader.begin();
+    try {
+        loader.set_transform(tf);
+        cout << "set_transform in the middle of a pass: accepted (WRONG)" << endl;
+    }
+    catch (std::logic_error& e) {
+        cout << "set_transform in the middle of a pass: " << e.what() << endl;
+    }
+    cout << endl << endl;
 }
 int main(int argc, char** argv) {
     case_data_wo_label_1();
@@ -0,0 +1,332 @@
+/*
+ * File:   sampler.h
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+#include "ann/xtensor_lib.h"
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+typedef xt::random::default_engine_type sampler_engine;
+
+/* Sampler: the order in which a DataLoader visits the samples of a dataset
+ *  + len(): number of indices produced by one pass
+ *  + sample(indices, engine): write the indices of one pass into "indices"
+ *      all the randomness comes from "engine" (owned by the loader, seeded per epoch)
+ * NOTE: a sampler does not keep a pointer to the dataset; its indices must be < dataset.len()
+ */
+class Sampler{
+public:
+    Sampler(){}
+    virtual ~Sampler(){}
+    virtual int len()=0;
+    virtual void sample(xt::xarray<unsigned long>& indices, sampler_engine& engine)=0;
+};
+
+//////////////////////////////////////////////////////////////////////
+/* SequentialSampler: 0, 1, ..., size-1
+ */
+class SequentialSampler: public Sampler{
+private:
+    int size;
+public:
+    SequentialSampler(int size): size(size){}
+    int len(){ return size; }
+    void sample(xt::xarray<unsigned long>& indices, sampler_engine&){
+        indices = xt::arange<unsigned long>(size);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* RandomSampler:
+ *  + replacement == false: a permutation of 0..size-1 (Fisher-Yates, see: xt::random::shuffle)
+ *  + replacement == true: num_samples indices drawn uniformly (num_samples < 0: size)
+ */
+class RandomSampler: public Sampler{
+private:
+    int size;
+    bool replacement;
+    int num_samples;
+public:
+    RandomSampler(int size, bool replacement = false, int num_samples = -1):
+    size(size), replacement(replacement), num_samples(num_samples < 0 ? size : num_samples){
+        if (!replacement && num_samples >= 0 && num_samples != size)
+            throw std::invalid_argument("num_samples needs replacement == true!");
+    }
+    int len(){ return num_samples; }
+    void sample(xt::xarray<unsigned long>& indices, sampler_engine& engine){
+        if (!replacement) {
+            indices = xt::arange<unsigned long>(size);
+            xt::random::shuffle(indices, engine);
+            return;
+        }
+        indices.resize({(size_t)num_samples});
+        std::uniform_int_distribution<unsigned long> dist(0, size - 1);
+        for (int idx = 0; idx < num_samples; idx++) indices(idx) = dist(engine);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* ChunkSampler: a shuffle for datasets read by chunks of chunk_rows consecutive samples
+ *      (see: ChunkedRows, e.g., ChunkedTensorDataset)
+ *  + the chunks are shuffled, then taken "window" at a time;
+ *      the samples of the chunks of a window are shuffled together
+ *  + a cache of "window" chunks loads each chunk once per pass, instead of once per sample
+ *  + window >= number of chunks: a full shuffle (as RandomSampler)
+ */
+class ChunkSampler: public Sampler{
+private:
+    int size, chunk_rows, window;
+    std::vector<int> chunks;
+public:
+    ChunkSampler(int size, int chunk_rows, int window):
+    size(size), chunk_rows(chunk_rows), window(window < 1 ? 1 : window){
+        if (chunk_rows < 1) throw std::invalid_argument("chunk_rows must be >= 1!");
+    }
+    int len(){ return size; }
+    void sample(xt::xarray<unsigned long>& indices, sampler_engine& engine){
+        int num_chunks = (size + chunk_rows - 1) / chunk_rows;
+        chunks.resize(num_chunks);
+        for (int k = 0; k < num_chunks; k++) chunks[k] = k;
+        shuffle_range(chunks.data(), num_chunks, engine);
+        indices.resize({(size_t)size});
+        unsigned long* out = indices.data();
+        int pos = 0;
+        for (int first = 0; first < num_chunks; first += window) {
+            int start = pos;
+            for (int k = first; k < num_chunks && k < first + window; k++) {
+                int end = std::min(size, (chunks[k] + 1) * chunk_rows);
+                for (int row = chunks[k] * chunk_rows; row < end; row++) out[pos++] = row;
+            }
+            shuffle_range(out + start, pos - start, engine);
+        }
+    }
+private:
+    template<typename T>
+    static void shuffle_range(T* first, int count, sampler_engine& engine){
+        for (int k = count - 1; k > 0; k--) {
+            std::uniform_int_distribution<int> dist(0, k);
+            std::swap(first[k], first[dist(engine)]);
+        }
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* WeightedRandomSampler: num_samples indices drawn with replacement,
+ *      index i with probability weights[i] / sum(weights)
+ *  + alias method (Vose): O(size) to build the tables, O(1) per draw
+ *  + class_weights(labels): weights that give every class the same probability,
+ *      to oversample rare classes without copying their samples
+ */
+class WeightedRandomSampler: public Sampler{
+private:
+    int size;
+    int num_samples;
+    std::vector<double> prob;   //prob[i]: keep i when the draw falls in its bucket
+    std::vector<int> alias;     //alias[i]: taken otherwise
+public:
+    WeightedRandomSampler(xt::xarray<double> weights, int num_samples = -1):
+    size((int)weights.size()), num_samples(num_samples < 0 ? (int)weights.size() : num_samples),
+    prob(weights.size()), alias(weights.size()){
+        double total = xt::sum(weights)();
+        if (size == 0 || !(total > 0) || xt::any(weights < 0))
+            throw std::invalid_argument("Weights must be >= 0 with a positive sum!");
+        //scaled[i] = weights[i] * size / total: buckets below 1 are "small", the others "large"
+        std::vector<double> scaled(size);
+        std::vector<int> small, large;
+        for (int idx = 0; idx < size; idx++) {
+            scaled[idx] = weights.flat(idx) * size / total;
+            if (scaled[idx] < 1.0) small.push_back(idx);
+            else large.push_back(idx);
+        }
+        //fill each small bucket with the excess of a large one
+        while (!small.empty() && !large.empty()) {
+            int less = small.back(), more = large.back();
+            small.pop_back();
+            prob[less] = scaled[less];
+            alias[less] = more;
+            scaled[more] -= 1.0 - scaled[less];
+            if (scaled[more] < 1.0) {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        //the rest are full up to rounding errors
+        for (size_t idx = 0; idx < large.size(); idx++) { prob[large[idx]] = 1.0; alias[large[idx]] = large[idx]; }
+        for (size_t idx = 0; idx < small.size(); idx++) { prob[small[idx]] = 1.0; alias[small[idx]] = small[idx]; }
+    }
+    int len(){ return num_samples; }
+    void sample(xt::xarray<unsigned long>& indices, sampler_engine& engine){
+        indices.resize({(size_t)num_samples});
+        std::uniform_int_distribution<int> bucket(0, size - 1);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        for (int idx = 0; idx < num_samples; idx++) {
+            int pick = bucket(engine);
+            indices(idx) = coin(engine) < prob[pick] ? pick : alias[pick];
+        }
+    }
+
+    /* class_weights(labels): weight of sample i = 1 / (number of samples in the class of i)
+     *      labels: class ids (1-D) or one-hot rows (2-D)
+     */
+    template<typename LType>
+    static xt::xarray<double> class_weights(xt::xarray<LType>& labels);
+};
+
+//////////////////////////////////////////////////////////////////////
+/* StratifiedSampler: a permutation of the samples where every class is spread evenly,
+ *      so that any run of consecutive indices (a batch) keeps the class proportions of the dataset
+ *  + labels: class ids (1-D) or one-hot rows (2-D)
+ *  + each pass: the samples of each class are shuffled, then the classes are interleaved:
+ *      the k-th sample of a class with n samples goes to the position (k + offset) / n,
+ *      offset being random per class
+ */
+class StratifiedSampler: public Sampler{
+private:
+    std::vector<std::vector<unsigned long>> classes;    //classes[c]: the samples of class c
+    std::vector<std::pair<double, unsigned long>> keys; //(position, sample) of one pass
+    int size;
+public:
+    template<typename LType>
+    StratifiedSampler(xt::xarray<LType>& labels);
+    int len(){ return size; }
+    int num_classes(){ return (int)classes.size(); }
+    void sample(xt::xarray<unsigned long>& indices, sampler_engine& engine){
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        keys.clear();
+        for (size_t c = 0; c < classes.size(); c++) {
+            std::vector<unsigned long>& members = classes[c];
+            int n = (int)members.size();
+            std::sort(members.begin(), members.end());      //same start for every pass => depends on engine only
+            for (int k = n - 1; k > 0; k--) {
+                std::uniform_int_distribution<int> dist(0, k);
+                std::swap(members[k], members[dist(engine)]);
+            }
+            double offset = coin(engine);
+            for (int k = 0; k < n; k++) keys.push_back(std::make_pair((k + offset) / n, members[k]));
+        }
+        std::sort(keys.begin(), keys.end());
+        indices.resize({(size_t)size});
+        for (int idx = 0; idx < size; idx++) indices(idx) = keys[idx].second;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* DistributedSampler: the share of one process (rank) among world_size processes
+ *  + every rank runs the same "sampler" with the same engine state (same seed and epoch)
+ *      => the same order on every rank, without any communication
+ *  + the order is cut into world_size contiguous shards of the same size; shard "rank" is kept
+ *      drop_last == false: the order is padded with its first indices up to a multiple of world_size
+ *      drop_last == true: the last (len() % world_size) indices are dropped
+ */
+class DistributedSampler: public Sampler{
+private:
+    Sampler* sampler;
+    int rank, world_size;
+    bool drop_last;
+    xt::xarray<unsigned long> all;      //the order of all the ranks
+public:
+    DistributedSampler(Sampler* sampler, int rank, int world_size, bool drop_last = false):
+    sampler(sampler), rank(rank), world_size(world_size), drop_last(drop_last){
+        if (world_size < 1 || rank < 0 || rank >= world_size)
+            throw std::out_of_range("rank must be in [0, world_size)!");
+    }
+    int len(){
+        int total = sampler->len();
+        return drop_last ? total / world_size : (total + world_size - 1) / world_size;
+    }
+    void sample(xt::xarray<unsigned long>& indices, sampler_engine& engine){
+        sampler->sample(all, engine);
+        int total = (int)all.size();
+        int share = drop_last ? total / world_size : (total + world_size - 1) / world_size;
+        indices.resize({(size_t)share});
+        for (int idx = 0; idx < share && total > 0; idx++) indices(idx) = all((rank * share + idx) % total);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* BatchSampler: groups the indices of a Sampler into batches
+ *  + sample(indices, offsets, engine): batch b is indices[offsets[b] .. offsets[b+1]-1]
+ *  + default grouping (same as DataLoader): len() / batch_size batches of batch_size indices;
+ *      if drop_last == false, the last batch also takes the remaining indices
+ *  + derive from it (override sample) for other groupings, e.g., batches of similar lengths
+ */
+class BatchSampler{
+protected:
+    Sampler* sampler;
+    int batch_size;
+    bool drop_last;
+public:
+    BatchSampler(Sampler* sampler, int batch_size, bool drop_last = false):
+    sampler(sampler), batch_size(batch_size), drop_last(drop_last){
+    }
+    virtual ~BatchSampler(){}
+    virtual void sample(xt::xarray<unsigned long>& indices, std::vector<int>& offsets, sampler_engine& engine){
+        sampler->sample(indices, engine);
+        int total = (int)indices.size();
+        int num = total / batch_size;
+        offsets.clear();
+        for (int idx = 0; idx <= num; idx++) offsets.push_back(idx * batch_size);
+        if (!drop_last && num > 0) offsets.back() = total;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+/* class_ids(labels): the class of each sample, as 0..C-1 in increasing order of label value
+ */
+template<typename LType>
+std::vector<int> class_ids(xt::xarray<LType>& labels, int& num_classes){
+    int size = labels.dimension() == 0 ? 0 : (int)labels.shape()[0];
+    std::vector<double> value(size);
+    if (labels.dimension() > 1) {
+        //one-hot rows: the class is the position of the largest value
+        size_t row = labels.size() / size;
+        const LType* ptr = labels.data();
+        for (int idx = 0; idx < size; idx++) {
+            const LType* first = ptr + idx * row;
+            value[idx] = (double)(std::max_element(first, first + row) - first);
+        }
+    }
+    else {
+        for (int idx = 0; idx < size; idx++) value[idx] = (double)labels(idx);
+    }
+    std::map<double, int> ids;
+    for (int idx = 0; idx < size; idx++) ids[value[idx]] = 0;
+    num_classes = 0;
+    for (std::map<double, int>::iterator it = ids.begin(); it != ids.end(); it++) it->second = num_classes++;
+    std::vector<int> result(size);
+    for (int idx = 0; idx < size; idx++) result[idx] = ids[value[idx]];
+    return result;
+}
+
+template<typename LType>
+xt::xarray<double> WeightedRandomSampler::class_weights(xt::xarray<LType>& labels){
+    int num_classes;
+    std::vector<int> ids = class_ids(labels, num_classes);
+    std::vector<int> count(num_classes, 0);
+    for (size_t idx = 0; idx < ids.size(); idx++) count[ids[idx]]++;
+    xt::xarray<double> weights = xt::zeros<double>({ids.size()});
+    for (size_t idx = 0; idx < ids.size(); idx++) weights(idx) = 1.0 / count[ids[idx]];
+    return weights;
+}
+
+template<typename LType>
+StratifiedSampler::StratifiedSampler(xt::xarray<LType>& labels){
+    int num_classes;
+    std::vector<int> ids = class_ids(labels, num_classes);
+    size = (int)ids.size();
+    classes.resize(num_classes);
+    for (int idx = 0; idx < size; idx++) classes[ids[idx]].push_back(idx);
+    keys.reserve(size);
+}
+
+#endif /* SAMPLER_H */
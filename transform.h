@@ -0,0 +1,175 @@
+/*
+ * File:   transform.h
+ */
+
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+#include "ann/xtensor_lib.h"
+#include <vector>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+
+using namespace std;
+
+/* Transform: what DataLoader does to each sample while it assembles a batch (see: DataLoader::set_transform)
+ *  + data steps, applied in the order they are added:
+ *      normalize(mean, std): (x - mean) / std
+ *      scale(min, max): (x - min) / (max - min), i.e., min-max scaling to [0, 1]
+ *      clip(low, high): x kept in [low, high]
+ *      cast<T>(): x converted to T and back, saturated to the range of T
+ *          (e.g., cast<unsigned char>() after scaling to [0, 255]: the values an 8-bit image would hold)
+ *    mean, std, min, max: one value, or one value per element of a sample,
+ *      or one value per element of its last dimension (e.g., per channel)
+ *  + one_hot(num_classes): the label (a class id per sample) becomes a row of num_classes values,
+ *      1 at the class, 0 elsewhere
+ *  + fused: each element of a row is read once, goes through all the steps, and is written once
+ *      (consecutive normalize/scale steps are merged into one multiply-add);
+ *      the row is processed in blocks of doubles that stay in cache, one tight loop per step
+ *      over a block (no branch per element => the loops can be vectorized)
+ * Example:
+ *      Transform<double, int> tf;
+ *      tf.normalize(mean, std).clip(-3, 3).one_hot(10);
+ *      loader.set_transform(tf);
+ */
+template<typename DType, typename LType>
+class Transform{
+private:
+    enum{ AFFINE, CLIP, CAST };
+    enum{ BLOCK = 256 };                //elements of a row processed together (see: apply)
+    struct Step{
+        int op;
+        xt::xarray<double> a, b;        //AFFINE: x * a + b; CLIP: [a, b]
+        void (*cast)(double*, size_t);
+    };
+    std::vector<Step> steps;
+    int classes;
+    //steps with a, b repeated for each element of a row (see: prepare)
+    std::vector<Step> fused;
+    size_t row;
+
+public:
+    Transform(): classes(0), row(0){}
+
+    Transform& normalize(xt::xarray<double> mean, xt::xarray<double> std){
+        if (xt::any(xt::equal(std, 0.0))) throw std::invalid_argument("std must not be 0!");
+        xt::xarray<double> a = 1.0 / std;
+        xt::xarray<double> b = -mean / std;
+        return add(AFFINE, a, b);
+    }
+    Transform& scale(xt::xarray<double> min, xt::xarray<double> max){
+        if (xt::any(xt::equal(max, min))) throw std::invalid_argument("max must differ from min!");
+        xt::xarray<double> a = 1.0 / (max - min);
+        xt::xarray<double> b = -min / (max - min);
+        return add(AFFINE, a, b);
+    }
+    Transform& clip(xt::xarray<double> low, xt::xarray<double> high){
+        return add(CLIP, low, high);
+    }
+    template<typename T>
+    Transform& cast(){
+        add(CAST, xt::xarray<double>(0.0), xt::xarray<double>(0.0));
+        steps.back().cast = &Transform::through<T>;
+        return *this;
+    }
+    Transform& one_hot(int num_classes){
+        if (num_classes < 1) throw std::invalid_argument("num_classes must be >= 1!");
+        classes = num_classes;
+        return *this;
+    }
+
+    int num_classes(){ return classes; }
+    bool has_data_steps(){ return !steps.empty(); }
+
+    /* prepare(size_t row): repeat the parameters for rows of "row" elements,
+     *      merge consecutive affine steps (once per DataLoader, not per batch)
+     *  >> throw an exception (std::invalid_argument) if a parameter does not fit the row
+     */
+    void prepare(size_t row){
+        this->row = row;
+        fused.clear();
+        for (size_t s = 0; s < steps.size(); s++) {
+            Step step = steps[s];
+            step.a = repeat(steps[s].a, row);
+            step.b = repeat(steps[s].b, row);
+            if (step.op == AFFINE && !fused.empty() && fused.back().op == AFFINE) {
+                //(x * a1 + b1) * a2 + b2 = x * (a1 * a2) + (b1 * a2 + b2)
+                Step& last = fused.back();
+                last.b = last.b * step.a + step.b;
+                last.a = last.a * step.a;
+            }
+            else fused.push_back(step);
+        }
+    }
+
+    /* apply(dst, src): dst = the row src after the data steps (dst may be src)
+     *      for each block of the row: load it as doubles, run each step over the whole block,
+     *      store it as DType (the steps are chosen once per block, not per element)
+     */
+    void apply(DType* dst, const DType* src) const{
+        double block[BLOCK];
+        for (size_t first = 0; first < row; first += BLOCK) {
+            size_t n = row - first < (size_t)BLOCK ? row - first : (size_t)BLOCK;
+            for (size_t e = 0; e < n; e++) block[e] = (double)src[first + e];
+            for (size_t s = 0; s < fused.size(); s++) {
+                const Step& step = fused[s];
+                const double* a = step.a.data() + first;
+                const double* b = step.b.data() + first;
+                if (step.op == AFFINE) {
+                    for (size_t e = 0; e < n; e++) block[e] = block[e] * a[e] + b[e];
+                }
+                else if (step.op == CLIP) {
+                    for (size_t e = 0; e < n; e++) {
+                        double value = block[e] < a[e] ? a[e] : block[e];
+                        block[e] = value > b[e] ? b[e] : value;
+                    }
+                }
+                else step.cast(block, n);
+            }
+            for (size_t e = 0; e < n; e++) dst[first + e] = (DType)block[e];
+        }
+    }
+
+    /* encode(ids, size, out): out (size x num_classes) = one-hot rows of the class ids
+     *  >> throw an exception (std::out_of_range) if an id is not in [0, num_classes)
+     */
+    void encode(const LType* ids, int size, LType* out) const{
+        std::fill(out, out + (size_t)size * classes, LType(0));
+        for (int j = 0; j < size; j++) {
+            long id = (long)ids[j];
+            if (id < 0 || id >= classes) throw out_of_range("Class id is out of range!");
+            out[(size_t)j * classes + id] = LType(1);
+        }
+    }
+
+private:
+    Transform& add(int op, xt::xarray<double> a, xt::xarray<double> b){
+        Step step;
+        step.op = op;
+        step.a = a;
+        step.b = b;
+        step.cast = 0;
+        steps.push_back(step);
+        return *this;
+    }
+    static xt::xarray<double> repeat(xt::xarray<double>& param, size_t row){
+        size_t n = param.size();
+        if (n == 0 || row % n != 0) throw std::invalid_argument("Transform parameter does not fit the samples!");
+        xt::xarray<double> result = xt::empty<double>({row});
+        for (size_t e = 0; e < row; e++) result(e) = param.data()[e % n];
+        return result;
+    }
+    /* through<T>(values, n): each value converted to T and back, saturated to the range of T
+     */
+    template<typename T>
+    static void through(double* values, size_t n){
+        const double low = (double)std::numeric_limits<T>::lowest(), high = (double)std::numeric_limits<T>::max();
+        for (size_t e = 0; e < n; e++) {
+            double value = values[e];
+            if (std::is_integral<T>::value) value = value < low ? low : (value > high ? high : value);
+            values[e] = (double)(T)value;
+        }
+    }
+};
+
+#endif /* TRANSFORM_H */
@@ -0,0 +1,84 @@
+/*
+ * File:   Hash.h
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <functional>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+using namespace std;
+
+/* defaultHash(U& item, 0):
+ *  + std::hash<U> if it exists (primitive types, string, pointers: hash by ADDRESS)
+ *  + otherwise (e.g., Point): never called, the containers refuse to be built without a hash
+ *      (see: checkHash)
+ */
+template <class U>
+auto defaultHash(U &item, int) -> decltype(std::hash<U>()(item))
+{
+    return std::hash<U>()(item);
+}
+template <class U>
+size_t defaultHash(U &, long)
+{
+    return 0;
+}
+
+/* hasDefaultHash<U>(): true if std::hash<U> exists
+ */
+template <class U>
+auto hasDefaultHash(int) -> decltype(std::hash<U>()(std::declval<U &>()), true)
+{
+    return true;
+}
+template <class U>
+bool hasDefaultHash(long)
+{
+    return false;
+}
+
+/* checkHash(itemEqual, itemHash): a hashed container needs a hash that agrees with its equality
+ *  >> throw an exception (std::invalid_argument) if itemHash == 0 and
+ *      + itemEqual != 0: std::hash (e.g., the ADDRESS of a pointer) would not follow itemEqual
+ *          => equal items in different slots, lookups that miss them
+ *      + or T has no std::hash: every item would get the same slot
+ */
+template <class T>
+void checkHash(bool (*itemEqual)(T &, T &), size_t (*itemHash)(T &))
+{
+    if (itemHash != 0)
+        return;
+    if (itemEqual != 0)
+        throw std::invalid_argument("An equality function needs a hash function that agrees with it!");
+    if (!hasDefaultHash<T>(0))
+        throw std::invalid_argument("This type has no std::hash: pass a hash function!");
+}
+
+/** hashItem:
+ * if itemHash == 0:
+ *      use std::hash<T> (see defaultHash)
+ * if T: pointer type (and itemEqual compares the content):
+ *      must pass itemHash to hash by CONTENT (checked, see: checkHash),
+ *      See: definition of "pointHash" of class Point for more detail
+ *
+ * The result is mixed: std::hash of integers is the identity,
+ *      so consecutive keys would fill consecutive slots of an open-addressing table.
+ */
+template <class T>
+size_t hashItem(T &item, size_t (*itemHash)(T &))
+{
+    size_t h;
+    if (itemHash == 0)
+        h = defaultHash(item, 0);
+    else
+        h = itemHash(item);
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h;
+}
+
+#endif /* HASH_H */
@@ -0,0 +1,99 @@
+/*
+ * File:   MappedFile.h
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/* MappedFile: the content of a file, mapped into memory
+ *  + opening is O(1): pages are read from disk on first access, by the OS
+ *  + the pages are shared with every process that maps the same file (page cache)
+ *  + copy-on-write: writing through data() changes only this process' copy, never the file
+ *  >> throw an exception (std::runtime_error) if the file cannot be opened or mapped, or is empty
+ *      (a mapping cannot have length 0)
+ */
+class MappedFile{
+private:
+    char* base;
+    size_t length;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#else
+    int fd;
+#endif
+
+public:
+    MappedFile(const string& path): base(0), length(0){
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open file: " + path);
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        length = (size_t)size.QuadPart;
+        if (length == 0) {
+            CloseHandle(file);
+            throw std::runtime_error("Empty file: " + path);
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapping != NULL) base = (char*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        if (base == 0) {
+            if (mapping != NULL) CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Cannot map file: " + path);
+        }
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open file: " + path);
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        length = (size_t)info.st_size;
+        if (length == 0) {
+            close(fd);
+            throw std::runtime_error("Empty file: " + path);
+        }
+        void* ptr = mmap(0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map file: " + path);
+        }
+        base = (char*)ptr;
+#endif
+    }
+    ~MappedFile(){
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+        CloseHandle(mapping);
+        CloseHandle(file);
+#else
+        munmap(base, length);
+        close(fd);
+#endif
+    }
+    MappedFile(const MappedFile& file) = delete;
+    MappedFile& operator=(const MappedFile& file) = delete;
+
+    char* data(){ return base; }
+    size_t size(){ return length; }
+};
+
+#endif /* MAPPEDFILE_H */
@@ -19,6 +19,7 @@
 #include <math.h>
 #include <random>
 #include <sstream>
+#include <functional>
 using namespace std;
 
 #define EPSILON (1E-8)
@@ -83,6 +84,28 @@ public:
         return  *lhs == *rhs;
     }
     
+    //hash by content: equal points (see: operator==, EPSILON) give the same hash
+    static size_t pointHash(Point& point){
+        size_t h = std::hash<float>()(hashKey(point.x));
+        h ^= std::hash<float>()(hashKey(point.y)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= std::hash<float>()(hashKey(point.z)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+    //with pointer to point
+    static size_t pointHash(Point*& point){
+        return pointHash(*point);
+    }
+
+    /* hashKey(v): the value hashed for a coordinate v, so that |v1 - v2| < EPSILON => same key
+     *  + |v| > 0.125: consecutive floats are at least 2^-26 (> EPSILON) apart,
+     *      so v is only equal to itself => v
+     *  + |v| <= 0.125: consecutive floats are less than EPSILON apart, every value is linked
+     *      to 0 by a chain of equal neighbours => one key for all of them
+     */
+    static float hashKey(float v){
+        return fabs(v) <= 0.125f ? 0.0f : v;
+    }
+
     static string point2str(Point& point){
         stringstream os;
         os  << point;
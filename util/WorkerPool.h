@@ -0,0 +1,139 @@
+/*
+ * File:   WorkerPool.h
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+#include <exception>
+#include <chrono>
+#include <vector>
+using namespace std;
+
+/* WorkerPool:
+ *  + a fixed set of threads that run the tasks 0..ntasks-1 of a job (see: run)
+ *  + tasks are claimed one at a time from a shared counter: a worker that finishes early
+ *      takes the remaining tasks of the slower ones, so uneven task costs stay balanced
+ *  + keeps, for each worker, the time spent in tasks and the number of tasks done
+ */
+class WorkerPool{
+private:
+    std::vector<std::thread> workers;
+    std::mutex pool_mutex;
+    std::mutex run_mutex;                       //one job at a time
+    std::condition_variable job_ready, job_done;
+    void (*job)(void*, int);                    //job(job_context, task)
+    void* job_context;
+    int job_size;
+    std::atomic<int> next_task;
+    int active;                                 //workers still in the current job
+    unsigned long generation;                   //id of the current job
+    bool stopping;
+    std::exception_ptr job_error;
+    std::vector<double> busy_seconds;
+    std::vector<long> tasks_done;
+    std::chrono::steady_clock::time_point created;
+
+public:
+    WorkerPool(int num_workers): job(0), job_context(0), job_size(0), next_task(0), active(0), generation(0), stopping(false),
+        busy_seconds(num_workers, 0.0), tasks_done(num_workers, 0) {
+        created = std::chrono::steady_clock::now();
+        for (int idx = 0; idx < num_workers; idx++) {
+            workers.push_back(std::thread(&WorkerPool::work, this, idx));
+        }
+    }
+    ~WorkerPool(){
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            stopping = true;
+        }
+        job_ready.notify_all();
+        for (size_t idx = 0; idx < workers.size(); idx++) workers[idx].join();
+    }
+
+    int size(){ return (int)workers.size(); }
+
+    /* run(int ntasks, task): call task(0), ..., task(ntasks-1) on the workers,
+     *      return when all of them are done
+     *  >> the first exception thrown by a task is rethrown here
+     * NOTE: task is called through a pointer, it is not copied => no allocation per job
+     */
+    template<typename Task>
+    void run(int ntasks, Task&& task){
+        typedef typename std::remove_reference<Task>::type Callable;
+        run(ntasks, &WorkerPool::invoke<Callable>, (void*)&task);
+    }
+    void run(int ntasks, void (*task)(void*, int), void* context){
+        std::lock_guard<std::mutex> run_lock(run_mutex);
+        std::unique_lock<std::mutex> lock(pool_mutex);
+        job = task;
+        job_context = context;
+        job_size = ntasks;
+        next_task = 0;
+        job_error = nullptr;
+        active = (int)workers.size();
+        generation++;
+        job_ready.notify_all();
+        job_done.wait(lock, [this]{ return active == 0; });
+        job = 0;
+        job_context = 0;
+        if (job_error) std::rethrow_exception(job_error);
+    }
+
+    /* utilization(int worker): fraction of the time since the pool was created
+     *      that the worker spent in tasks
+     */
+    double utilization(int worker){
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - created).count();
+        return elapsed > 0 ? busy_seconds[worker] / elapsed : 0.0;
+    }
+    long tasks(int worker){
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        return tasks_done[worker];
+    }
+
+private:
+    template<typename Callable>
+    static void invoke(void* context, int task){
+        (*(Callable*)context)(task);
+    }
+
+    void work(int worker){
+        unsigned long seen = 0;
+        while (true) {
+            std::unique_lock<std::mutex> lock(pool_mutex);
+            job_ready.wait(lock, [&]{ return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            lock.unlock();
+
+            auto start = std::chrono::steady_clock::now();
+            long done = 0;
+            std::exception_ptr error = nullptr;
+            for (int task = next_task++; task < job_size; task = next_task++) {
+                try {
+                    job(job_context, task);
+                }
+                catch (...) {
+                    if (!error) error = std::current_exception();
+                }
+                done++;
+            }
+            double busy = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            busy_seconds[worker] += busy;
+            tasks_done[worker] += done;
+            if (error && !job_error) job_error = error;
+            if (--active == 0) job_done.notify_all();
+        }
+    }
+};
+
+#endif /* WORKERPOOL_H */